@@ -0,0 +1,106 @@
+#include "Bench.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifndef BENCH_MIN_RUN_MS
+#define BENCH_MIN_RUN_MS 200
+#endif
+
+static Bench::Registration* s_head = nullptr;
+static Bench::Registration* s_tail = nullptr;
+
+// Heap allocations made by the code under test while a benchmark runs.
+static bool s_countAllocations = false;
+static unsigned long s_allocations = 0;
+static unsigned long s_allocatedBytes = 0;
+
+static void* allocate(size_t size)
+{
+    if (s_countAllocations)
+    {
+        s_allocations++;
+        s_allocatedBytes += size;
+    }
+    void* memory = malloc(size ? size : 1);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+Bench::Registration::Registration(const char* name, Function function)
+    : name(name), function(function), next(nullptr)
+{
+    // Keep the definition order, so results are listed file by file.
+    if (s_tail)
+    {
+        s_tail->next = this;
+    }
+    else
+    {
+        s_head = this;
+    }
+    s_tail = this;
+}
+
+static double runTimed(Bench::Function function, uint32_t iterations)
+{
+    s_allocations = 0;
+    s_allocatedBytes = 0;
+    s_countAllocations = true;
+    auto start = std::chrono::steady_clock::now();
+    function(iterations);
+    auto end = std::chrono::steady_clock::now();
+    s_countAllocations = false;
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+int Bench::runAll(const char* filter)
+{
+    int count = 0;
+
+    printf("%-36s %12s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op", "B/op");
+    for (Registration* current = s_head; current != nullptr; current = current->next)
+    {
+        if (filter && !strstr(current->name, filter))
+        {
+            continue;
+        }
+
+        // Warm-up, then grow the run until it is long enough for a stable per-op time.
+        runTimed(current->function, 1);
+        uint32_t iterations = 1;
+        double elapsedNs = runTimed(current->function, iterations);
+        const double minRunNs = BENCH_MIN_RUN_MS * 1e6;
+        while (elapsedNs < minRunNs && iterations < 1000000000UL)
+        {
+            double scale = elapsedNs > 0 ? minRunNs * 1.2 / elapsedNs : 100;
+            if (scale > 100) scale = 100;
+            if (scale < 2) scale = 2;
+            iterations = (uint32_t)(iterations * scale);
+            elapsedNs = runTimed(current->function, iterations);
+        }
+
+        printf("%-36s %12lu %12.1f %12.2f %12.1f\n",
+               current->name,
+               (unsigned long)iterations,
+               elapsedNs / iterations,
+               (double)s_allocations / iterations,
+               (double)s_allocatedBytes / iterations);
+        count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,53 @@
+#ifndef AHA_DEVICES_BENCH_H
+#define AHA_DEVICES_BENCH_H
+
+#include <stdint.h>
+
+/**
+ * @brief Tiny benchmark harness for the host-native suite (pio run -e native -t exec).
+ * A benchmark is a function that performs its operation `iterations` times:
+ *   BENCHMARK(Button_idle)
+ *   {
+ *       for (uint32_t i = 0; i < iterations; ++i) { ... }
+ *   }
+ * The runner grows the iteration count until a run takes at least BENCH_MIN_RUN_MS and
+ * reports ns/op together with heap allocations (operator new) and bytes per op.
+ */
+namespace Bench
+{
+    using Function = void (*)(uint32_t iterations);
+
+    /**
+     * @brief Adds a benchmark to the suite, created by BENCHMARK().
+     */
+    struct Registration
+    {
+        Registration(const char* name, Function function);
+
+        const char* name;
+        Function function;
+        Registration* next;
+    };
+
+    /**
+     * @brief Runs every benchmark whose name contains `filter` (all with nullptr) and prints
+     * one result line per benchmark. Returns the number of benchmarks run.
+     */
+    int runAll(const char* filter);
+
+    /**
+     * @brief Keeps the compiler from optimizing away a computed value.
+     */
+    template <typename T>
+    inline void doNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#define BENCHMARK(name) \
+    static void name(uint32_t iterations); \
+    static Bench::Registration name##Registration(#name, name); \
+    static void name(uint32_t iterations)
+
+#endif // AHA_DEVICES_BENCH_H
@@ -0,0 +1,101 @@
+#include "Bench.h"
+#include "Button/Button.h"
+#include "Button/ButtonMapper.h"
+
+/**
+ * @brief Button with the input fed by the benchmark instead of a pin.
+ */
+class BenchButton : public Button
+{
+public:
+    explicit BenchButton(uint16_t id) : Button(id, 0) {}
+
+    void loop() override {}
+};
+
+enum class BenchButtonId : uint8_t
+{
+    UNKNOWN = 0,
+    FIRST,
+    LAST = 32
+};
+
+// The size of a typical controller mapping, the searched ID is at the end.
+static const ButtonMapping<BenchButtonId> s_buttonMap[32] = {
+    {1, (BenchButtonId)1}, {2, (BenchButtonId)2}, {3, (BenchButtonId)3}, {4, (BenchButtonId)4},
+    {5, (BenchButtonId)5}, {6, (BenchButtonId)6}, {7, (BenchButtonId)7}, {8, (BenchButtonId)8},
+    {9, (BenchButtonId)9}, {10, (BenchButtonId)10}, {11, (BenchButtonId)11}, {12, (BenchButtonId)12},
+    {13, (BenchButtonId)13}, {14, (BenchButtonId)14}, {15, (BenchButtonId)15}, {16, (BenchButtonId)16},
+    {17, (BenchButtonId)17}, {18, (BenchButtonId)18}, {19, (BenchButtonId)19}, {20, (BenchButtonId)20},
+    {21, (BenchButtonId)21}, {22, (BenchButtonId)22}, {23, (BenchButtonId)23}, {24, (BenchButtonId)24},
+    {25, (BenchButtonId)25}, {26, (BenchButtonId)26}, {27, (BenchButtonId)27}, {28, (BenchButtonId)28},
+    {29, (BenchButtonId)29}, {30, (BenchButtonId)30}, {31, (BenchButtonId)31}, {32, BenchButtonId::LAST},
+};
+
+// Volatile, so the lookups are not folded at compile time.
+static volatile uint16_t s_lastControlPointId = 32;
+static volatile uint16_t s_missingControlPointId = 1000;
+
+/**
+ * @brief Feeds `pressed` for `durationMs` in 15 ms steps (one RTOS tick) and returns the
+ * number of non-idle events.
+ */
+static uint8_t holdFor(BenchButton& button, bool pressed, unsigned long durationMs)
+{
+    uint8_t events = 0;
+    for (unsigned long elapsed = 0; elapsed < durationMs; elapsed += 15)
+    {
+        BenchShim::advanceMs(15);
+        if (button.getButtonEvent(pressed) != BUTTON_EVENT_IDLE)
+        {
+            events++;
+        }
+    }
+    return events;
+}
+
+BENCHMARK(Button_getButtonEvent_idle)
+{
+    BenchButton button(1);
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        BenchShim::advanceMs(15);
+        Bench::doNotOptimize(button.getButtonEvent(false));
+    }
+}
+
+BENCHMARK(Button_click_sequence)
+{
+    BenchButton button(1);
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        Bench::doNotOptimize(holdFor(button, true, 150));
+        Bench::doNotOptimize(holdFor(button, false, 450));
+    }
+}
+
+BENCHMARK(Button_long_press_sequence)
+{
+    BenchButton button(1);
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        Bench::doNotOptimize(holdFor(button, true, 1500));
+        Bench::doNotOptimize(holdFor(button, false, 450));
+    }
+}
+
+BENCHMARK(ButtonMapper_getButtonId_last)
+{
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        Bench::doNotOptimize(getButtonId(s_buttonMap, s_lastControlPointId));
+    }
+}
+
+BENCHMARK(ButtonMapper_getButtonId_missing)
+{
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        Bench::doNotOptimize(getButtonId(s_buttonMap, s_missingControlPointId));
+    }
+}
@@ -0,0 +1,84 @@
+#include "Bench.h"
+#include "Cover/Cover.h"
+
+// Covers are never unlinked from Cover's instance list, so they are created once and
+// shared by all benchmarks: one moving cover and the rest idle, as on a typical controller.
+static const uint8_t BENCH_COVER_COUNT = 8;
+static const long BENCH_COURSE_MS = 3000;
+
+static Cover* s_covers[BENCH_COVER_COUNT];
+
+static Cover& benchCovers()
+{
+    static bool created = false;
+    if (!created)
+    {
+        static const char* ids[BENCH_COVER_COUNT] = {
+            "cover_0", "cover_1", "cover_2", "cover_3", "cover_4", "cover_5", "cover_6", "cover_7"
+        };
+        for (uint8_t i = 0; i < BENCH_COVER_COUNT; ++i)
+        {
+            // The first cover has tilt, like a venetian blind.
+            s_covers[i] = new Cover(
+                new HACover(ids[i]), ids[i], 2 * i + 2, 2 * i + 3, BENCH_COURSE_MS,
+                i * EepromService::blockSize<long>(), 10,
+                i == 0 ? 1000 : 0, 2048, 10
+            );
+        }
+        Cover::setup();
+        created = true;
+    }
+    return *s_covers[0];
+}
+
+/**
+ * @brief Runs Cover::loop() every RTOS tick (15 ms) until the moving cover is idle again.
+ */
+static void runUntilIdle(Cover& cover)
+{
+    Cover::loop();
+    while (cover.isTargeting())
+    {
+        BenchShim::advanceMs(15);
+        Cover::loop();
+    }
+    // Let the safety delay after the stop expire, like the time between two commands.
+    BenchShim::advanceMs(300);
+}
+
+BENCHMARK(Cover_loop_idle_8_covers)
+{
+    benchCovers();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        BenchShim::advanceMs(15);
+        Cover::loop();
+    }
+}
+
+BENCHMARK(Cover_full_course_with_tilt)
+{
+    Cover& cover = benchCovers();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        if (i & 1)
+        {
+            cover.open();
+        }
+        else
+        {
+            cover.close();
+        }
+        runUntilIdle(cover);
+    }
+}
+
+BENCHMARK(Cover_partial_move)
+{
+    Cover& cover = benchCovers();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        cover.setTargetPosition(i & 1 ? 40 : 60);
+        runUntilIdle(cover);
+    }
+}
@@ -0,0 +1,40 @@
+#include "Bench.h"
+#include "EepromSerivce.h"
+
+// Away from the addresses used by the Cover benchmarks.
+static const uint16_t BENCH_EEPROM_ADDRESS = 3072;
+
+BENCHMARK(EepromService_write_long_10_slots)
+{
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        EepromService::write<long>(BENCH_EEPROM_ADDRESS, (long)i, 10);
+    }
+}
+
+BENCHMARK(EepromService_read_long_10_slots)
+{
+    EepromService::write<long>(BENCH_EEPROM_ADDRESS, 42L, 10);
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        Bench::doNotOptimize(EepromService::read<long>(BENCH_EEPROM_ADDRESS, 0L, 10));
+    }
+}
+
+BENCHMARK(EepromService_write_long_40_slots)
+{
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        EepromService::write<long>(BENCH_EEPROM_ADDRESS, (long)i, 40);
+    }
+}
+
+BENCHMARK(EepromService_writeBehind_long)
+{
+    // Caller-side cost only: the value is cached, the write happens in flushDue().
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        EepromService::writeBehind<long>(BENCH_EEPROM_ADDRESS + 512, (long)i, 10);
+    }
+    EepromService::flush();
+}
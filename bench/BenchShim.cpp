@@ -0,0 +1,17 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "Bus/MqttBusLock.h"
+
+unsigned long BenchShim::nowMs = 0;
+uint8_t BenchShim::pinLevels[70] = {};
+
+EEPROMClass EEPROM;
+
+// No MQTT client on the host, device code runs unlocked.
+MqttBusLock::MqttBusLock() : _bus(nullptr)
+{
+}
+
+MqttBusLock::~MqttBusLock()
+{
+}
@@ -0,0 +1,20 @@
+#include <cstdio>
+#include "Bench.h"
+
+/**
+ * Host-native benchmarks of the controller hot paths, built by the `native` environment:
+ *   pio run -e native -t exec
+ * Pass a substring to run only matching benchmarks, e.g. `.pio/build/native/program Cover`.
+ * Run it before and after a change to the benchmarked code; the numbers are only
+ * comparable on the same machine.
+ */
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    if (Bench::runAll(filter) == 0)
+    {
+        fprintf(stderr, "No benchmark matches '%s'\n", filter);
+        return 1;
+    }
+    return 0;
+}
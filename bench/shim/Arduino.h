@@ -0,0 +1,76 @@
+#ifndef AHA_DEVICES_BENCH_SHIM_ARDUINO_H
+#define AHA_DEVICES_BENCH_SHIM_ARDUINO_H
+
+/**
+ * @brief Minimal host replacement of the Arduino core, only what the benchmarked sources use.
+ * Time is simulated: millis()/micros() return BenchShim::nowMs, which the benchmarks advance,
+ * so the state machines run exactly as on the board without waiting.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+// Flash strings are ordinary strings on the host.
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define PSTR(string_literal) (string_literal)
+#define PROGMEM
+
+namespace BenchShim
+{
+    extern unsigned long nowMs;
+    extern uint8_t pinLevels[70];
+
+    inline void advanceMs(unsigned long ms)
+    {
+        nowMs += ms;
+    }
+}
+
+inline unsigned long millis()
+{
+    return BenchShim::nowMs;
+}
+
+inline unsigned long micros()
+{
+    return BenchShim::nowMs * 1000UL;
+}
+
+inline void pinMode(uint8_t, uint8_t)
+{
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+    BenchShim::pinLevels[pin] = level;
+}
+
+inline int digitalRead(uint8_t pin)
+{
+    return BenchShim::pinLevels[pin];
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+inline size_t strlen_P(const char* string)
+{
+    return strlen(string);
+}
+
+inline char* strcpy_P(char* destination, const char* source)
+{
+    return strcpy(destination, source);
+}
+
+#endif // AHA_DEVICES_BENCH_SHIM_ARDUINO_H
@@ -0,0 +1,70 @@
+#ifndef AHA_DEVICES_BENCH_SHIM_ARDUINOHA_H
+#define AHA_DEVICES_BENCH_SHIM_ARDUINOHA_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Host stand-ins for the ArduinoHA device types. Setters only keep the value,
+ * so the benchmarks measure the controller logic without the MQTT publishing cost.
+ */
+class HABase
+{
+public:
+    explicit HABase(const char* uniqueId) : _uniqueId(uniqueId) {}
+
+    const char* uniqueId() const { return _uniqueId; }
+    void setName(const char* name) { _name = name; }
+    void setIcon(const char* icon) { _icon = icon; }
+
+protected:
+    const char* _uniqueId;
+    const char* _name = nullptr;
+    const char* _icon = nullptr;
+};
+
+class HACover : public HABase
+{
+public:
+    enum CoverState
+    {
+        StateUnknown = 0,
+        StateClosed,
+        StateClosing,
+        StateOpen,
+        StateOpening,
+        StateStopped
+    };
+
+    enum CoverCommand
+    {
+        CommandOpen,
+        CommandClose,
+        CommandStop
+    };
+
+    explicit HACover(const char* uniqueId) : HABase(uniqueId) {}
+
+    void setDeviceClass(const char* deviceClass) { _deviceClass = deviceClass; }
+    bool setState(CoverState state, bool = false) { _state = state; return true; }
+    bool setPosition(int16_t position, bool = false) { _position = position; return true; }
+    bool setTilt(int16_t tilt, bool = false) { _tilt = tilt; return true; }
+    void setRetain(bool) {}
+    void setOptimistic(bool) {}
+    void onCommand(void (*callback)(CoverCommand, HACover*)) { _commandCallback = callback; }
+    void onSetPositionCommand(void (*callback)(uint8_t, HACover*)) { _positionCallback = callback; }
+    void onTiltCommand(void (*callback)(uint8_t, HACover*)) { _tiltCallback = callback; }
+
+    CoverState getState() const { return _state; }
+    int16_t getPosition() const { return _position; }
+
+private:
+    const char* _deviceClass = nullptr;
+    CoverState _state = StateUnknown;
+    int16_t _position = 0;
+    int16_t _tilt = 0;
+    void (*_commandCallback)(CoverCommand, HACover*) = nullptr;
+    void (*_positionCallback)(uint8_t, HACover*) = nullptr;
+    void (*_tiltCallback)(uint8_t, HACover*) = nullptr;
+};
+
+#endif // AHA_DEVICES_BENCH_SHIM_ARDUINOHA_H
@@ -0,0 +1,58 @@
+#ifndef AHA_DEVICES_BENCH_SHIM_EEPROM_H
+#define AHA_DEVICES_BENCH_SHIM_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief RAM-backed EEPROM with the ATmega2560 size. Like the AVR library, put() only
+ * writes bytes that change; byteWrites counts them, to compare the wear of write strategies.
+ */
+struct EEPROMClass
+{
+    static const uint16_t SIZE = 4096;
+
+    uint8_t data[SIZE];
+    unsigned long byteWrites = 0;
+
+    EEPROMClass() { clear(); }
+
+    void clear() { memset(data, 0xFF, sizeof(data)); }
+
+    uint8_t read(int address) const { return data[address]; }
+    void write(int address, uint8_t value)
+    {
+        data[address] = value;
+        byteWrites++;
+    }
+    void update(int address, uint8_t value)
+    {
+        if (data[address] != value)
+        {
+            write(address, value);
+        }
+    }
+    uint16_t length() const { return SIZE; }
+
+    template <typename T>
+    T& get(int address, T& value) const
+    {
+        memcpy(&value, &data[address], sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            update(address + i, bytes[i]);
+        }
+        return value;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // AHA_DEVICES_BENCH_SHIM_EEPROM_H
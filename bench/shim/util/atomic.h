@@ -0,0 +1,8 @@
+#ifndef AHA_DEVICES_BENCH_SHIM_ATOMIC_H
+#define AHA_DEVICES_BENCH_SHIM_ATOMIC_H
+
+// The benchmarks are single-threaded, an atomic block is an ordinary block.
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type) for (bool _atomicOnce = true; _atomicOnce; _atomicOnce = false)
+
+#endif // AHA_DEVICES_BENCH_SHIM_ATOMIC_H
@@ -0,0 +1,353 @@
+/**
+ * Firmware image for the simavr environment, see tools/simavr_run.sh.
+ * It runs the real controller code on the simulated ATmega2560 and prints exact CPU cycle
+ * counts (ProfilingClock, Timer5 at the CPU clock) over UART0:
+ *  - EepromService slot scans, measured in setup() before the scheduler starts,
+ *  - the loopFunc of each ControllerRunner task, for SIMAVR_RUN_SECONDS of simulated time.
+ * The buttons are driven through their own GPIO pins. AnalogButton gets its ADC readings from
+ * the stimulus through the analogRead() wrapper below, the DS18B20 buses use the synthetic
+ * sensors from bench/simavr/stub.
+ * At the end it checks the button events against the stimulus and prints "simavr: PASS" or
+ * "simavr: FAIL", which tools/simavr_run.sh turns into its exit status. Then it disables
+ * interrupts and sleeps, which ends the simavr run.
+ */
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include "ControllerRunner.h"
+#include "ProfilingClock.h"
+#include "EepromSerivce.h"
+#include "Button/DigitalButton.h"
+#include "Button/AnalogButton.h"
+#include "DS18B20/DS18B20MultiPin.h"
+
+#ifndef PROFILINGCLOCK
+#error "The simavr image needs PROFILINGCLOCK, see [env:simavr] in platformio.ini"
+#endif
+
+#ifndef SIMAVR_RUN_SECONDS
+#define SIMAVR_RUN_SECONDS 30
+#endif
+
+/**
+ * @struct CycleProbe
+ * @brief Cycle statistics of one measured call site.
+ */
+struct CycleProbe
+{
+    const char* name;
+    uint32_t calls;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint32_t totalCycles; // Wraps after 268 s of measured time.
+};
+
+// Cost of an empty measurement, subtracted from every sample.
+static uint32_t s_overheadCycles = 0;
+
+static void probeRecord(CycleProbe& probe, uint32_t startCycles)
+{
+    uint32_t cycles = ProfilingClock::now() - startCycles - s_overheadCycles;
+    probe.calls++;
+    probe.totalCycles += cycles;
+    if (probe.calls == 1 || cycles < probe.minCycles) probe.minCycles = cycles;
+    if (cycles > probe.maxCycles) probe.maxCycles = cycles;
+}
+
+static void probePrint(const CycleProbe& probe)
+{
+    Serial.print(probe.name);
+    Serial.print(F(" calls="));
+    Serial.print(probe.calls);
+    Serial.print(F(" cycles min/avg/max="));
+    Serial.print(probe.minCycles);
+    Serial.print('/');
+    Serial.print(probe.calls > 0 ? probe.totalCycles / probe.calls : 0);
+    Serial.print('/');
+    Serial.println(probe.maxCycles);
+}
+
+#define PROBE(probe, statement) \
+    do \
+    { \
+        uint32_t probeStart = ProfilingClock::now(); \
+        statement; \
+        probeRecord(probe, probeStart); \
+    } while (0)
+
+// --- EepromService, measured before the scheduler starts ---
+
+static const uint16_t SIM_EEPROM_ADDRESS = 3072;
+
+static void benchEeprom()
+{
+    CycleProbe write10 = {"EepromService::write<long> 10 slots"};
+    CycleProbe read10 = {"EepromService::read<long> 10 slots"};
+    CycleProbe write40 = {"EepromService::write<long> 40 slots"};
+    CycleProbe flush = {"EepromService::flush (EepromWriter drain)"};
+
+    for (uint8_t i = 0; i < 20; ++i)
+    {
+        PROBE(write10, EepromService::write<long>(SIM_EEPROM_ADDRESS, (long)i, 10));
+        volatile long value;
+        PROBE(read10, value = EepromService::read<long>(SIM_EEPROM_ADDRESS, 0L, 10));
+        (void)value;
+        PROBE(write40, EepromService::write<long>(SIM_EEPROM_ADDRESS + 256, (long)i, 40));
+        // Keeps the writes above from waiting for queue space.
+        PROBE(flush, EepromService::flush());
+    }
+
+    probePrint(write10);
+    probePrint(read10);
+    probePrint(write40);
+    probePrint(flush);
+}
+
+// --- Tasks ---
+
+static const uint8_t SIM_BUTTON_COUNT = 8;
+static const uint8_t SIM_BUTTON_FIRST_PIN = 22; // PORTA
+
+static DigitalButton* s_buttons[SIM_BUTTON_COUNT];
+static AnalogButton* s_analogButton;
+static const uint8_t s_temperaturePins[] = {30, 31, 32, 33};
+static DS18B20MultiPin s_temperatures(s_temperaturePins, sizeof(s_temperaturePins));
+
+// Events reported by the buttons, indexed by ButtonEvent.
+static uint16_t s_digitalEvents[BUTTON_EVENT_TRIPLE_CLICKED + 1];
+static uint16_t s_analogEvents[BUTTON_EVENT_TRIPLE_CLICKED + 1];
+static uint16_t s_analogWrongVoltage = 0; // Events that reported another voltage than pressed.
+
+// Presses driven by the stimulus.
+static uint16_t s_digitalPresses = 0;
+static uint16_t s_analogPresses = 0;
+
+// ADC value the stimulus puts on the AnalogButton input, see __wrap_analogRead().
+static volatile uint16_t s_adcValue = 0;
+static const uint16_t SIM_ADC_PRESSED = 800; // 24 V at 30 mV per step
+static const uint16_t SIM_ADC_NOISE = 100;   // 3 V, below the press threshold
+static const uint8_t SIM_PRESSED_VOLTS = 24;
+
+static CycleProbe s_buttonProbe = {"Buttons loopFunc (8 DigitalButton + 1 AnalogButton)"};
+static CycleProbe s_temperatureProbe = {"DS18B20MultiPin::loop (max = _readAll)"};
+
+extern "C" int __real_analogRead(uint8_t pin);
+
+/**
+ * @brief Replaces analogRead() in the simavr image (-Wl,--wrap=analogRead in platformio.ini):
+ * simavr has no way to drive the ADC input from the command line. The real conversion still
+ * runs, so the measured cycles include it, but the stimulus value is returned.
+ */
+extern "C" int __wrap_analogRead(uint8_t pin)
+{
+    __real_analogRead(pin);
+    return s_adcValue;
+}
+
+static void onDigitalButton(ButtonEvent event, DigitalButton*)
+{
+    s_digitalEvents[event]++;
+}
+
+static void onAnalogButton(ButtonEvent event, uint8_t voltage, AnalogButton*)
+{
+    s_analogEvents[event]++;
+    if (voltage != SIM_PRESSED_VOLTS)
+    {
+        s_analogWrongVoltage++;
+    }
+}
+
+static void buttonsSetup()
+{
+    for (uint8_t i = 0; i < SIM_BUTTON_COUNT; ++i)
+    {
+        s_buttons[i] = new DigitalButton(i + 1, SIM_BUTTON_FIRST_PIN + i, onDigitalButton);
+        // Output, so digitalRead() returns the level this task drives.
+        pinMode(SIM_BUTTON_FIRST_PIN + i, OUTPUT);
+    }
+    s_analogButton = new AnalogButton(100, A0, onAnalogButton);
+}
+
+/**
+ * @brief Drives the inputs, not measured. Every digital button is clicked (150 ms of each
+ * 600 ms, staggered). The analog button is held for 1500 ms of each 3000 ms, which is a press
+ * and a long press, and sees 3 V noise for 500 ms of the rest.
+ */
+static void drive()
+{
+    static unsigned long start = millis();
+    static uint8_t digitalLevels = 0;
+    static bool analogPressed = false;
+
+    unsigned long now = millis() - start;
+    for (uint8_t i = 0; i < SIM_BUTTON_COUNT; ++i)
+    {
+        bool pressed = (now + i * 75) % 600 < 150;
+        if (pressed && !(digitalLevels & _BV(i)))
+        {
+            s_digitalPresses++;
+        }
+        digitalLevels = pressed ? digitalLevels | _BV(i) : digitalLevels & ~_BV(i);
+        digitalWrite(SIM_BUTTON_FIRST_PIN + i, pressed ? HIGH : LOW);
+    }
+
+    unsigned long phase = now % 3000;
+    bool pressed = phase < 1500;
+    if (pressed && !analogPressed)
+    {
+        s_analogPresses++;
+    }
+    analogPressed = pressed;
+    s_adcValue = pressed ? SIM_ADC_PRESSED : (phase >= 2000 && phase < 2500 ? SIM_ADC_NOISE : 0);
+}
+
+static void buttonsLoop()
+{
+    drive();
+
+    PROBE(s_buttonProbe, {
+        for (uint8_t i = 0; i < SIM_BUTTON_COUNT; ++i)
+        {
+            s_buttons[i]->loop();
+        }
+        s_analogButton->loop();
+    });
+}
+
+/**
+ * @brief Checks that a count matches the driven presses. The last press may still be in
+ * progress when the run ends, so one event less is accepted.
+ */
+static bool expectPresses(const __FlashStringHelper* what, uint16_t count, uint16_t presses)
+{
+    bool ok = presses > 0 && count <= presses && count + 1 >= presses;
+    Serial.print(ok ? F("  ok   ") : F("  FAIL "));
+    Serial.print(what);
+    Serial.print(F(": "));
+    Serial.print(count);
+    Serial.print(F(" for "));
+    Serial.print(presses);
+    Serial.println(F(" presses"));
+    return ok;
+}
+
+static bool expectZero(const __FlashStringHelper* what, uint16_t count)
+{
+    bool ok = count == 0;
+    Serial.print(ok ? F("  ok   ") : F("  FAIL "));
+    Serial.print(what);
+    Serial.print(F(": "));
+    Serial.println(count);
+    return ok;
+}
+
+/**
+ * @brief Compares the button events with the stimulus from drive(). Returns true if all match.
+ */
+static bool checkButtons()
+{
+    // Snapshot, the BTN task runs at a higher priority.
+    taskENTER_CRITICAL();
+    uint16_t digital[BUTTON_EVENT_TRIPLE_CLICKED + 1];
+    uint16_t analog[BUTTON_EVENT_TRIPLE_CLICKED + 1];
+    memcpy(digital, s_digitalEvents, sizeof(digital));
+    memcpy(analog, s_analogEvents, sizeof(analog));
+    uint16_t digitalPresses = s_digitalPresses;
+    uint16_t analogPresses = s_analogPresses;
+    uint16_t wrongVoltage = s_analogWrongVoltage;
+    taskEXIT_CRITICAL();
+
+    uint16_t digitalOther = 0;
+    uint16_t analogOther = 0;
+    for (uint8_t event = BUTTON_EVENT_RELEASED; event <= BUTTON_EVENT_TRIPLE_CLICKED; ++event)
+    {
+        if (event != BUTTON_EVENT_CLICKED) digitalOther += digital[event];
+        if (event != BUTTON_EVENT_PRESSED && event != BUTTON_EVENT_LONG_PRESSED && event != BUTTON_EVENT_RELEASED)
+        {
+            analogOther += analog[event];
+        }
+    }
+
+    bool ok = true;
+    Serial.println(F("Button checks:"));
+    ok &= expectPresses(F("DigitalButton CLICKED"), digital[BUTTON_EVENT_CLICKED], digitalPresses);
+    ok &= expectZero(F("DigitalButton other events"), digitalOther);
+    ok &= expectPresses(F("AnalogButton PRESSED"), analog[BUTTON_EVENT_PRESSED], analogPresses);
+    ok &= expectPresses(F("AnalogButton LONG_PRESSED"), analog[BUTTON_EVENT_LONG_PRESSED], analogPresses);
+    ok &= expectPresses(F("AnalogButton RELEASED"), analog[BUTTON_EVENT_RELEASED], analogPresses);
+    ok &= expectZero(F("AnalogButton other events (3 V noise)"), analogOther);
+    ok &= expectZero(F("AnalogButton events with a wrong voltage"), wrongVoltage);
+    return ok;
+}
+
+static void temperaturesSetup()
+{
+    s_temperatures.begin();
+}
+
+static void temperaturesLoop()
+{
+    PROBE(s_temperatureProbe, s_temperatures.loop());
+}
+
+static void reportLoop()
+{
+    static uint16_t seconds = 0;
+    if (++seconds < SIMAVR_RUN_SECONDS)
+    {
+        return;
+    }
+
+    probePrint(s_buttonProbe);
+    probePrint(s_temperatureProbe);
+    bool passed = checkButtons();
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        TaskStats stats;
+        if (ControllerRunner::getTaskStats(i, stats))
+        {
+            Serial.print(F("Task "));
+            Serial.print(i);
+            Serial.print(F(" iterations="));
+            Serial.print(stats.iterations);
+            Serial.print(F(" deadlineMisses="));
+            Serial.print(stats.deadlineMisses);
+            Serial.print(F(" maxUs="));
+            Serial.println(stats.maxExecutionUs);
+        }
+    }
+    Serial.println(passed ? F("simavr: PASS") : F("simavr: FAIL"));
+    Serial.flush();
+
+    // Sleeping with interrupts disabled ends the simulation.
+    cli();
+    sleep_enable();
+    sleep_cpu();
+}
+
+static const TaskConfig s_tasks[] = {
+    {"BTN", buttonsSetup, buttonsLoop, 192, 2, DelayType::PERIODIC, 1},
+    {"DS", temperaturesSetup, temperaturesLoop, 192, 1, DelayType::PERIODIC, pdMS_TO_TICKS(100)},
+    {"RPT", nullptr, reportLoop, 256, 1, DelayType::PERIODIC, pdMS_TO_TICKS(1000)},
+};
+
+void setup()
+{
+    Serial.begin(115200);
+    ProfilingClock::begin();
+
+    uint32_t start = ProfilingClock::now();
+    s_overheadCycles = ProfilingClock::now() - start;
+    Serial.print(F("Measurement overhead (subtracted): "));
+    Serial.print(s_overheadCycles);
+    Serial.println(F(" cycles"));
+
+    benchEeprom();
+
+    ControllerRunner::run(s_tasks, sizeof(s_tasks) / sizeof(s_tasks[0]));
+}
+
+void loop()
+{
+}
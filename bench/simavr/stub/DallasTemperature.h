@@ -0,0 +1,54 @@
+#ifndef AHA_DEVICES_SIMAVR_STUB_DALLASTEMPERATURE_H
+#define AHA_DEVICES_SIMAVR_STUB_DALLASTEMPERATURE_H
+
+#include <OneWire.h>
+
+typedef uint8_t DeviceAddress[8];
+
+#define DEVICE_DISCONNECTED_C -127
+
+/**
+ * @brief Stand-in for DallasTemperature in the simavr image. Every bus has one sensor
+ * with the address 28 <pin> 00..., whose reading steps through 20.00..21.94 degC, so
+ * DS18B20/DS18B20MultiPin run their full filtering math on every read.
+ */
+class DallasTemperature
+{
+public:
+    explicit DallasTemperature(OneWire* oneWire) : _oneWire(oneWire) {}
+
+    void begin() {}
+    void setOneWire(OneWire* oneWire) { _oneWire = oneWire; }
+    void setWaitForConversion(bool) {}
+    void setResolution(uint8_t) {}
+    bool setResolution(const uint8_t*, uint8_t, bool = true) { return true; }
+
+    bool getAddress(uint8_t* address, uint8_t index)
+    {
+        if (index != 0)
+        {
+            return false;
+        }
+        memset(address, 0, 8);
+        address[0] = 0x28;
+        address[1] = _oneWire->getPin();
+        return true;
+    }
+
+    void requestTemperatures() { _oneWire->conversions++; }
+    bool requestTemperaturesByAddress(const uint8_t*)
+    {
+        _oneWire->conversions++;
+        return true;
+    }
+
+    float getTempC(const uint8_t*)
+    {
+        return 20.0f + 0.0625f * (_oneWire->conversions % 32);
+    }
+
+private:
+    OneWire* _oneWire;
+};
+
+#endif // AHA_DEVICES_SIMAVR_STUB_DALLASTEMPERATURE_H
@@ -0,0 +1,24 @@
+#ifndef AHA_DEVICES_SIMAVR_STUB_ONEWIRE_H
+#define AHA_DEVICES_SIMAVR_STUB_ONEWIRE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Stand-in for the OneWire library in the simavr image: simavr has no 1-Wire
+ * devices, so each bus reports one synthetic DS18B20 (see DallasTemperature.h).
+ */
+class OneWire
+{
+public:
+    explicit OneWire(uint8_t pin) : _pin(pin) {}
+
+    uint8_t getPin() const { return _pin; }
+
+    // Conversions requested on this bus, drives the synthetic temperature.
+    uint16_t conversions = 0;
+
+private:
+    uint8_t _pin;
+};
+
+#endif // AHA_DEVICES_SIMAVR_STUB_ONEWIRE_H
@@ -0,0 +1,151 @@
+#define DEBUG_MODULE LogModule::RUNNER
+#include "BootProfiler.h"
+
+#ifdef BOOTPROFILE
+#include <Arduino_FreeRTOS.h>
+
+static BootProfileEntry s_entries[BOOT_PROFILER_MAX_ENTRIES];
+static uint8_t s_count = 0;
+static uint8_t s_dropped = 0;
+static bool s_published = false;
+
+uint8_t BootProfiler::begin(const __FlashStringHelper* stage, const char* name, uint8_t index)
+{
+    // Setup functions of different tasks run concurrently, so the slot is reserved atomically.
+    // The entry is filled in before it becomes visible through count().
+    uint32_t startMs = millis();
+    uint32_t startUs = micros();
+
+    taskENTER_CRITICAL();
+    uint8_t slot = s_count;
+    if (slot < BOOT_PROFILER_MAX_ENTRIES)
+    {
+        // durationUs holds the start time in micros() until the step ends.
+        s_entries[slot] = BootProfileEntry{stage, name, index, startMs, startUs, false};
+        s_count++;
+    }
+    else if (s_dropped < 0xFF)
+    {
+        s_dropped++;
+    }
+    taskEXIT_CRITICAL();
+
+    return slot;
+}
+
+void BootProfiler::end(uint8_t slot)
+{
+    if (slot < BOOT_PROFILER_MAX_ENTRIES)
+    {
+        uint32_t durationUs = micros() - s_entries[slot].durationUs;
+        taskENTER_CRITICAL();
+        s_entries[slot].durationUs = durationUs;
+        s_entries[slot].done = true;
+        taskEXIT_CRITICAL();
+    }
+}
+
+bool BootProfiler::getEntry(uint8_t index, BootProfileEntry& entry)
+{
+    if (index >= count())
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    entry = s_entries[index];
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+uint8_t BootProfiler::count()
+{
+    taskENTER_CRITICAL();
+    uint8_t count = s_count;
+    taskEXIT_CRITICAL();
+    return count;
+}
+
+void BootProfiler::report()
+{
+    DPRINTLN(F("--- Boot profile ---"));
+    BootProfileEntry entry;
+    for (uint8_t i = 0; getEntry(i, entry); ++i)
+    {
+        DPRINT(F("@"));
+        DPRINT(entry.startMs);
+        DPRINT(F("ms "));
+        DPRINT(entry.stage);
+        if (entry.name)
+        {
+            DPRINT(F(" "));
+            DPRINT(entry.name);
+        }
+        if (entry.index != BOOT_PROFILE_NO_INDEX)
+        {
+            DPRINT(F(" #"));
+            DPRINT(entry.index);
+        }
+        DPRINT(F(": "));
+        if (entry.done)
+        {
+            DPRINT(entry.durationUs);
+            DPRINTLN(F("us"));
+        }
+        else
+        {
+            DPRINTLN(F("running"));
+        }
+    }
+    if (s_dropped > 0)
+    {
+        DPRINT(F("Dropped: "));
+        DPRINTLN(s_dropped);
+    }
+}
+
+bool BootProfiler::publish(HAMqtt& mqtt, const char* topic)
+{
+    if (s_published)
+    {
+        return true;
+    }
+    if (!mqtt.isConnected())
+    {
+        return false;
+    }
+
+    uint32_t readyMs = millis();
+    char payload[128];
+
+    BootProfileEntry entry;
+    for (uint8_t i = 0; getEntry(i, entry); ++i)
+    {
+        // %S prints the flash-resident stage label (avr-libc).
+        snprintf_P(payload, sizeof(payload),
+                   PSTR("{\"stage\":\"%S\",\"name\":\"%s\",\"index\":%d,\"at_ms\":%lu,\"us\":%lu}"),
+                   reinterpret_cast<const char*>(entry.stage),
+                   entry.name ? entry.name : "",
+                   entry.index != BOOT_PROFILE_NO_INDEX ? (int)entry.index : -1,
+                   (unsigned long)entry.startMs,
+                   entry.done ? (unsigned long)entry.durationUs : 0UL);
+        if (!mqtt.publish(topic, payload))
+        {
+            return false; // Retry everything on the next call.
+        }
+    }
+
+    snprintf_P(payload, sizeof(payload),
+               PSTR("{\"ready_ms\":%lu,\"steps\":%u,\"dropped\":%u}"),
+               (unsigned long)readyMs, (unsigned)count(), (unsigned)s_dropped);
+    s_published = mqtt.publish(topic, payload);
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+    if (s_published)
+    {
+        report();
+    }
+#endif
+    return s_published;
+}
+#endif
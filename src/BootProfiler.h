@@ -0,0 +1,102 @@
+#ifndef AHA_DEVICES_BOOT_PROFILER_H
+#define AHA_DEVICES_BOOT_PROFILER_H
+
+#include <Arduino.h>
+#include <Debug.h>
+
+// Topic MqttBus publishes the boot profile to.
+#ifndef BOOT_PROFILER_TOPIC
+#define BOOT_PROFILER_TOPIC "aha/boot_profile"
+#endif
+
+// Value of BootProfileEntry::index for steps without an instance number.
+#define BOOT_PROFILE_NO_INDEX 0xFF
+
+// Maximum number of setup steps recorded; later steps are counted as dropped.
+#ifndef BOOT_PROFILER_MAX_ENTRIES
+#define BOOT_PROFILER_MAX_ENTRIES 24
+#endif
+
+#ifdef BOOTPROFILE
+#include <ArduinoHA.h>
+
+/**
+ * @struct BootProfileEntry
+ * @brief One timed setup step, e.g. a task's setupFunc or the _setup() of a single device.
+ */
+struct BootProfileEntry
+{
+    const __FlashStringHelper* stage; // What ran, e.g. F("Cover").
+    const char* name; // Which instance or task, may be nullptr.
+    uint8_t index; // Instance number for steps without a name, e.g. a pin, or BOOT_PROFILE_NO_INDEX.
+    uint32_t startMs; // millis() when the step started, i.e. time since reset.
+    uint32_t durationUs; // Duration of the step.
+    bool done;
+};
+
+namespace BootProfiler
+{
+    /**
+     * @brief Starts timing a setup step. Safe from any task, before and after the scheduler starts.
+     * @param stage Short label of the step (use F() macro).
+     * @param name Optional instance or task name; must stay valid until the results are published.
+     * @param index Optional instance number, e.g. the pin of a bus that has no name.
+     * @return Slot of the entry for end(), or BOOT_PROFILER_MAX_ENTRIES if the table is full.
+     */
+    uint8_t begin(const __FlashStringHelper* stage, const char* name = nullptr, uint8_t index = BOOT_PROFILE_NO_INDEX);
+
+    /**
+     * @brief Stops timing the step started by begin().
+     */
+    void end(uint8_t slot);
+
+    /**
+     * @brief Copies a recorded entry.
+     * @return false if the index is out of range.
+     */
+    bool getEntry(uint8_t index, BootProfileEntry& entry);
+
+    /**
+     * @brief Returns the number of recorded entries.
+     */
+    uint8_t count();
+
+    /**
+     * @brief Prints the breakdown through DPRINT.
+     */
+    void report();
+
+    /**
+     * @brief Publishes the breakdown once MQTT is connected, one JSON message per step followed
+     * by a summary with the time from reset to the first connection. MqttBus calls it with
+     * BOOT_PROFILER_TOPIC; without MqttBus call it from the task that runs HAMqtt::loop().
+     * It does nothing until connected and after the first successful call.
+     * @param mqtt The MQTT client.
+     * @param topic The topic to publish to.
+     * @return true once everything has been published.
+     */
+    bool publish(HAMqtt& mqtt, const char* topic);
+
+    /**
+     * @class Scope
+     * @brief Times the enclosing block, see BOOT_PROFILE_SCOPE.
+     */
+    class Scope
+    {
+    public:
+        Scope(const __FlashStringHelper* stage, const char* name = nullptr, uint8_t index = BOOT_PROFILE_NO_INDEX)
+            : _slot(begin(stage, name, index)) {}
+        ~Scope() { end(_slot); }
+
+    private:
+        uint8_t _slot;
+    };
+}
+
+// BOOT_PROFILE_SCOPE(stage, name) or BOOT_PROFILE_SCOPE(stage, name, index).
+#define BOOT_PROFILE_SCOPE(stage, ...) BootProfiler::Scope _bootProfileScope(stage, __VA_ARGS__)
+#else
+#define BOOT_PROFILE_SCOPE(stage, ...)
+#endif
+
+#endif // AHA_DEVICES_BOOT_PROFILER_H
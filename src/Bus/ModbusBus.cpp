@@ -0,0 +1,121 @@
+#define DEBUG_MODULE LogModule::BUS
+#include "ModbusBus.h"
+
+ModbusBus::ModbusBus(ModbusRTUMaster* master, uint8_t queueLength)
+    : _master(master),
+      _queueLength(queueLength),
+      _queue(NULL)
+{
+}
+
+bool ModbusBus::begin(UBaseType_t taskPriority, uint16_t stackSize)
+{
+    // The queue only carries pointers, the requests themselves stay on the callers' stacks.
+    _queue = xQueueCreate(_queueLength, sizeof(Request*));
+    if (_queue == NULL)
+    {
+        EPRINTLN(F("[ModbusBus] ERROR: Could not create queue"));
+        return false;
+    }
+
+    if (xTaskCreate(_task, "MBUS", stackSize, this, taskPriority, NULL) != pdPASS)
+    {
+        EPRINTLN(F("[ModbusBus] ERROR: Could not create task"));
+        return false;
+    }
+    return true;
+}
+
+uint8_t ModbusBus::writeMultipleHoldingRegisters(uint8_t id, uint16_t startAddress, uint16_t* buffer,
+                                                 uint16_t quantity, Priority priority)
+{
+    return _execute(OP_WRITE_MULTIPLE_HOLDING_REGISTERS, id, startAddress, buffer, quantity, priority);
+}
+
+uint8_t ModbusBus::readHoldingRegisters(uint8_t id, uint16_t startAddress, uint16_t* buffer,
+                                        uint16_t quantity, Priority priority)
+{
+    return _execute(OP_READ_HOLDING_REGISTERS, id, startAddress, buffer, quantity, priority);
+}
+
+uint8_t ModbusBus::_execute(Operation operation, uint8_t id, uint16_t startAddress, uint16_t* buffer,
+                            uint16_t quantity, Priority priority)
+{
+    Request request = {
+        .operation = operation,
+        .id = id,
+        .startAddress = startAddress,
+        .buffer = buffer,
+        .quantity = quantity,
+        .caller = NULL,
+        .result = 0,
+        .done = false
+    };
+
+    // Before the scheduler runs (setup()) there is nobody to compete with.
+    if (_queue == NULL || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return _executeDirect(request);
+    }
+
+    request.caller = xTaskGetCurrentTaskHandle();
+    Request* item = &request;
+    BaseType_t queued = priority == PRIORITY_HIGH
+                            ? xQueueSendToFront(_queue, &item, portMAX_DELAY)
+                            : xQueueSendToBack(_queue, &item, portMAX_DELAY);
+    if (queued != pdPASS)
+    {
+        return 0xFF;
+    }
+
+    // Wait one notification at a time. Notifications meant for something else (e.g.
+    // ControllerRunner::notify on an EVENT task) are handed back once we are done.
+    uint8_t foreignNotifications = 0;
+    while (!request.done)
+    {
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+        if (!request.done)
+        {
+            foreignNotifications++;
+        }
+    }
+    while (foreignNotifications-- > 0)
+    {
+        xTaskNotifyGive(request.caller);
+    }
+
+    return request.result;
+}
+
+uint8_t ModbusBus::_executeDirect(const Request& request)
+{
+    switch (request.operation)
+    {
+    case OP_WRITE_MULTIPLE_HOLDING_REGISTERS:
+        return _master->writeMultipleHoldingRegisters(request.id, request.startAddress, request.buffer,
+                                                      request.quantity);
+    case OP_READ_HOLDING_REGISTERS:
+        return _master->readHoldingRegisters(request.id, request.startAddress, request.buffer, request.quantity);
+    }
+    return 0xFF;
+}
+
+void ModbusBus::_task(void* pvParameters)
+{
+    ModbusBus* bus = static_cast<ModbusBus*>(pvParameters);
+
+    for (;;)
+    {
+        Request* request;
+        if (xQueueReceive(bus->_queue, &request, portMAX_DELAY) != pdPASS)
+        {
+            continue;
+        }
+
+        // The request may go out of scope as soon as done is set, copy what we still need.
+        TaskHandle_t caller = request->caller;
+        request->result = bus->_executeDirect(*request);
+        request->done = true;
+        xTaskNotifyGive(caller);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef AHA_DEVICES_MODBUSBUS_H
+#define AHA_DEVICES_MODBUSBUS_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include <queue.h>
+#include <ModbusRTUMaster.h>
+#include "Debug.h"
+
+/**
+ * @class ModbusBus
+ * @brief Bus arbiter for a shared ModbusRTUMaster.
+ * A dedicated task owns the master and executes transactions one at a time from a FreeRTOS
+ * queue, so any task can issue requests without interleaving frames on the wire. High priority
+ * requests are put at the front of the queue. Callers block until their own transaction is done.
+ */
+class ModbusBus
+{
+public:
+    enum Priority : uint8_t
+    {
+        PRIORITY_NORMAL,
+        PRIORITY_HIGH
+    };
+
+    /**
+     * @param master The Modbus master; after begin() it must only be used through this bus.
+     * @param queueLength Maximum number of pending transactions.
+     */
+    explicit ModbusBus(ModbusRTUMaster* master, uint8_t queueLength = 4);
+
+    /**
+     * @brief Creates the queue and the bus task. Call before the scheduler starts.
+     * @param taskPriority Priority of the bus task, usually above the device tasks using it.
+     * @param stackSize Stack size of the bus task.
+     * @return false if the queue or the task could not be created.
+     */
+    bool begin(UBaseType_t taskPriority, uint16_t stackSize = 192);
+
+    // Same signatures and error codes as ModbusRTUMaster, executed by the bus task.
+    uint8_t writeMultipleHoldingRegisters(uint8_t id, uint16_t startAddress, uint16_t* buffer, uint16_t quantity,
+                                          Priority priority = PRIORITY_NORMAL);
+    uint8_t readHoldingRegisters(uint8_t id, uint16_t startAddress, uint16_t* buffer, uint16_t quantity,
+                                 Priority priority = PRIORITY_NORMAL);
+
+private:
+    enum Operation : uint8_t
+    {
+        OP_WRITE_MULTIPLE_HOLDING_REGISTERS,
+        OP_READ_HOLDING_REGISTERS
+    };
+
+    // Queue item. It lives on the caller's stack until the caller is notified.
+    struct Request
+    {
+        Operation operation;
+        uint8_t id;
+        uint16_t startAddress;
+        uint16_t* buffer;
+        uint16_t quantity;
+        TaskHandle_t caller;
+        volatile uint8_t result;
+        volatile bool done;
+    };
+
+    ModbusRTUMaster* _master;
+    uint8_t _queueLength;
+    QueueHandle_t _queue;
+
+    uint8_t _execute(Operation operation, uint8_t id, uint16_t startAddress, uint16_t* buffer, uint16_t quantity,
+                     Priority priority);
+    uint8_t _executeDirect(const Request& request);
+    static void _task(void* pvParameters);
+};
+
+#endif //AHA_DEVICES_MODBUSBUS_H
@@ -0,0 +1,108 @@
+#define DEBUG_MODULE LogModule::BUS
+#include "MqttBus.h"
+#include "BootProfiler.h"
+
+MqttBus::MqttBus(HAMqtt* mqtt, uint8_t queueLength, TickType_t loopTicks)
+    : _mqtt(mqtt),
+      _queueLength(queueLength),
+      _loopTicks(loopTicks),
+      _queue(NULL),
+      _mutex(NULL),
+      _droppedJobs(0)
+{
+}
+
+bool MqttBus::begin(UBaseType_t taskPriority, uint16_t stackSize)
+{
+    _mutex = xSemaphoreCreateRecursiveMutex();
+    _queue = xQueueCreate(_queueLength, sizeof(Item));
+    if (_mutex == NULL || _queue == NULL)
+    {
+        EPRINTLN(F("[MqttBus] ERROR: Could not create mutex/queue"));
+        return false;
+    }
+
+    if (xTaskCreate(_task, "MQTT", stackSize, this, taskPriority, NULL) != pdPASS)
+    {
+        EPRINTLN(F("[MqttBus] ERROR: Could not create task"));
+        return false;
+    }
+    _started = this;
+    return true;
+}
+
+bool MqttBus::post(Job job, void* arg, Priority priority)
+{
+    Item item = {job, arg};
+    BaseType_t queued = priority == PRIORITY_HIGH
+                            ? xQueueSendToFront(_queue, &item, 0)
+                            : xQueueSendToBack(_queue, &item, 0);
+    if (queued != pdPASS)
+    {
+        _droppedJobs++;
+        return false;
+    }
+    return true;
+}
+
+void MqttBus::lock()
+{
+    if (_mutex != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+    }
+}
+
+void MqttBus::unlock()
+{
+    if (_mutex != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    {
+        xSemaphoreGiveRecursive(_mutex);
+    }
+}
+
+void MqttBus::_task(void* pvParameters)
+{
+    MqttBus* bus = static_cast<MqttBus*>(pvParameters);
+
+    for (;;)
+    {
+        // Wait for a job, but not longer than the client loop interval.
+        Item item;
+        bool received = xQueueReceive(bus->_queue, &item, bus->_loopTicks) == pdPASS;
+
+        Lock lock(*bus);
+        while (received)
+        {
+            item.job(item.arg);
+            received = xQueueReceive(bus->_queue, &item, 0) == pdPASS;
+        }
+        bus->_mqtt->loop();
+
+#ifdef BOOTPROFILE
+        // Once, after the first connection.
+        static bool bootProfilePublished = false;
+        if (!bootProfilePublished)
+        {
+            bootProfilePublished = BootProfiler::publish(*bus->_mqtt, BOOT_PROFILER_TOPIC);
+        }
+#endif
+    }
+}
+
+MqttBusLock::MqttBusLock()
+    : _bus(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING ? MqttBus::_started : nullptr)
+{
+    if (_bus)
+    {
+        _bus->lock();
+    }
+}
+
+MqttBusLock::~MqttBusLock()
+{
+    if (_bus)
+    {
+        _bus->unlock();
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef AHA_DEVICES_MQTTBUS_H
+#define AHA_DEVICES_MQTTBUS_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <ArduinoHA.h>
+#include "Debug.h"
+#include "MqttBusLock.h"
+
+/**
+ * @class MqttBus
+ * @brief Bus arbiter for the shared HAMqtt client.
+ * A dedicated task runs HAMqtt::loop() and executes jobs posted by other tasks from a
+ * FreeRTOS queue (high priority jobs go first), so publishing never races the client loop.
+ * Code that must call HA entities directly from another task can hold the bus with Lock.
+ * Devices do so through MqttBusLock, which finds the bus started by begin().
+ * With BOOTPROFILE the bus task also publishes the boot profile once connected, see
+ * BootProfiler::publish(); it needs about 200 more bytes of stack then.
+ */
+class MqttBus
+{
+public:
+    enum Priority : uint8_t
+    {
+        PRIORITY_NORMAL,
+        PRIORITY_HIGH
+    };
+
+    typedef void (*Job)(void* arg);
+
+    /**
+     * @brief RAII guard giving the current task exclusive access to the MQTT client.
+     */
+    class Lock
+    {
+    public:
+        explicit Lock(MqttBus& bus) : _bus(bus) { _bus.lock(); }
+        ~Lock() { _bus.unlock(); }
+
+    private:
+        MqttBus& _bus;
+    };
+
+    /**
+     * @param mqtt The HA MQTT client; after begin() only the bus task calls its loop().
+     * @param queueLength Maximum number of pending jobs.
+     * @param loopTicks Interval between HAMqtt::loop() calls when no job arrives.
+     */
+    explicit MqttBus(HAMqtt* mqtt, uint8_t queueLength = 8, TickType_t loopTicks = pdMS_TO_TICKS(20));
+
+    /**
+     * @brief Creates the mutex, the queue and the bus task. Call before the scheduler starts.
+     * @return false if any of them could not be created.
+     */
+    bool begin(UBaseType_t taskPriority, uint16_t stackSize = 384);
+
+    /**
+     * @brief Queues a job to run in the bus task. Never blocks.
+     * @return false if the queue is full and the job was dropped.
+     */
+    bool post(Job job, void* arg = nullptr, Priority priority = PRIORITY_NORMAL);
+
+    // Recursive, so a job may call code that takes the lock again.
+    void lock();
+    void unlock();
+
+    // Number of jobs dropped because the queue was full.
+    uint16_t getDroppedJobs() const { return _droppedJobs; }
+
+private:
+    struct Item
+    {
+        Job job;
+        void* arg;
+    };
+
+    HAMqtt* _mqtt;
+    uint8_t _queueLength;
+    TickType_t _loopTicks;
+    QueueHandle_t _queue;
+    SemaphoreHandle_t _mutex;
+    volatile uint16_t _droppedJobs;
+
+    inline static MqttBus* _started = nullptr; // Bus held by MqttBusLock.
+
+    static void _task(void* pvParameters);
+
+    friend class MqttBusLock;
+};
+
+#endif //AHA_DEVICES_MQTTBUS_H
@@ -0,0 +1,27 @@
+#ifndef AHA_DEVICES_MQTTBUSLOCK_H
+#define AHA_DEVICES_MQTTBUSLOCK_H
+
+class MqttBus;
+
+/**
+ * @class MqttBusLock
+ * @brief Holds the MqttBus started by MqttBus::begin() for the current scope, so HA entity
+ * calls made from device tasks never race HAMqtt::loop() in the bus task.
+ * Does nothing without a started bus, before the scheduler runs or while it is suspended
+ * (safe-state hooks), so devices can use it whether or not the firmware uses MqttBus.
+ * Kept apart from MqttBus.h, so device code does not depend on the FreeRTOS queue headers.
+ */
+class MqttBusLock
+{
+public:
+    MqttBusLock();
+    ~MqttBusLock();
+
+    MqttBusLock(const MqttBusLock&) = delete;
+    MqttBusLock& operator=(const MqttBusLock&) = delete;
+
+private:
+    MqttBus* _bus;
+};
+
+#endif //AHA_DEVICES_MQTTBUSLOCK_H
@@ -1,4 +1,5 @@
 #include "AnalogButton.h"
+#include "LatencyTrace.h"
 
 // The voltage threshold above which we consider a button to be pressed.
 const uint8_t ANALOG_BUTTON_PRESS_THRESHOLD_V = 4;
@@ -38,7 +39,9 @@ void AnalogButton::loop()
         // - For PRESSED/LONG_PRESSED, it was just updated with the current voltage.
         // - For RELEASED/CLICKED, it holds the value from just before the physical release.
         // This solves the problem entirely.
+        LATENCY_TRACE_DISPATCH(_id);
         _callback(event, _samplesSum / _samplesCount, this);
+        LATENCY_TRACE_DISPATCH_DONE();
         _samplesCount = 0;
         _samplesSum = 0;
     }
@@ -3,6 +3,11 @@
 //
 
 #include "Button.h"
+#include "LatencyTrace.h"
+#ifdef TRACEPOINTS_BUTTON
+#define TRACEPOINTS_ENABLED
+#endif
+#include "Trace/Tracepoint.h"
 
 
 ButtonEvent Button::getButtonEvent(bool buttonState)
@@ -14,6 +19,10 @@ ButtonEvent Button::getButtonEvent(bool buttonState)
     {
         // reset the debouncing timer
         _debounceTime = millis();
+        LATENCY_TRACE_EDGE(_id);
+#ifdef LATENCYTRACE
+        _latencyEdgeOpen = true;
+#endif
     }
 
     uint16_t timeDiff = millis() - _debounceTime;
@@ -62,6 +71,16 @@ ButtonEvent Button::getButtonEvent(bool buttonState)
 
                 _clickCounter = 0;
             }
+
+#ifdef LATENCYTRACE
+            // Back to idle without an event (a glitch shorter than a gesture): the traced
+            // edge must not be charged to the next gesture.
+            if (_latencyEdgeOpen && !_pressing && _clickCounter == 0 && event == BUTTON_EVENT_IDLE)
+            {
+                LATENCY_TRACE_IDLE(_id);
+                _latencyEdgeOpen = false;
+            }
+#endif
         }
         else
         {
@@ -96,5 +115,11 @@ ButtonEvent Button::getButtonEvent(bool buttonState)
 
     _lastButtonState = buttonState;
 
+    if (event != BUTTON_EVENT_IDLE)
+    {
+        LATENCY_TRACE_EVENT(_id);
+        TRACE_EVENT(TP_BUTTON_EVENT, ((int32_t)_id << 8) | event);
+    }
+
     return event;
 }
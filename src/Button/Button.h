@@ -6,6 +6,7 @@
 #define AHA_DEVICES_BUTTON_H
 
 #include <Arduino.h>
+#include "Debug.h"
 
 enum ButtonEvent : uint8_t
 {
@@ -34,6 +35,9 @@ protected:
     bool _pressEventSent = false;
     bool _longPressEventSent = false;
     bool _doublePressEventSent = false;
+#ifdef LATENCYTRACE
+    bool _latencyEdgeOpen = false; // An edge was traced and the button has not been idle since.
+#endif
 
     uint16_t _id;
     uint8_t _pin;
@@ -3,6 +3,7 @@
 //
 
 #include "DigitalButton.h"
+#include "LatencyTrace.h"
 
 void DigitalButton::loop()
 {
@@ -12,6 +13,8 @@ void DigitalButton::loop()
     // The check for _lastEvent is removed. We trust getButtonEvent.
     if (event != BUTTON_EVENT_IDLE)
     {
+        LATENCY_TRACE_DISPATCH(_id);
         _callback(event, this);
+        LATENCY_TRACE_DISPATCH_DONE();
     }
 }
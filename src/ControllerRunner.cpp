@@ -1,105 +1,1019 @@
+#define DEBUG_MODULE LogModule::RUNNER
 #include "ControllerRunner.h"
+#include "BootProfiler.h"
+#include "MemoryMonitor.h"
+#include "ProfilingClock.h"
+#include "Trace/Tracepoint.h"
 
-#ifdef DEBUGSTACK
-// Define the global semaphore for thread-safe printing, used by TaskMonitor.
-SemaphoreHandle_t g_serialSemaphore;
+#include <avr/wdt.h>
+
+/**
+ * @struct TaskRuntime
+ * @brief Mutable per-task state kept by the runner next to its (const) TaskConfig.
+ */
+struct TaskRuntime
+{
+    const TaskConfig* config;
+    TaskHandle_t handle;
+    TaskStats stats;
+#ifdef PROFILINGCLOCK
+    uint8_t totalRemainderCycles; // Measured cycles not yet counted in stats.totalExecutionUs.
+#endif
+    bool busy; // ADAPTIVE: result of isBusyFunc() after the previous iteration.
+    TickType_t nextWake; // Group members only: next release time.
+    TickType_t delayTicks; // Current period, starts at config->delayTicks (see setTaskPeriod()).
+    UBaseType_t priority; // Current priority, starts at config->priority (see setTaskPriority()).
+
+    // Supervisor heartbeat: tick of the last loopFunc start/end, and whether it is running now.
+    volatile TickType_t heartbeat;
+    volatile bool inLoop;
+    volatile bool started; // Set after setupFunc, the supervisor ignores the task before that.
+};
+
+static TaskRuntime s_tasks[CONTROLLER_RUNNER_MAX_TASKS];
+static size_t s_taskCount = 0;
+static TaskOverrunCallback s_overrunCallback = nullptr;
+
+static TickType_t s_supervisorTimeoutTicks = 0; // 0 = supervisor disabled.
+static SafeStateHook s_safeStateHooks[CONTROLLER_RUNNER_MAX_SAFE_STATE_HOOKS];
+static uint8_t s_safeStateHookCount = 0;
+
+static bool s_tuningPersisted = false;
+static uint16_t s_tuningAddress = 0;
+static uint8_t s_tuningSlots = 0;
+
+// CPU load accounting: counters at the previous getCpuLoad() call.
+static volatile uint32_t s_idleHookCalls = 0;
+static uint32_t s_loadWindowStartUs = 0;
+static uint32_t s_loadIdleHookCalls = 0;
+static uint32_t s_loadTaskUs[CONTROLLER_RUNNER_MAX_TASKS];
+
+#ifdef CPUSTATS
+#ifndef PROFILINGCLOCK
+#error "CPUSTATS measures on the ProfilingClock time base, define PROFILINGCLOCK"
 #endif
 
+// CPU cycles charged at context switches: per task table entry (leaders only), the idle task
+// and everything else. Written by vControllerRunnerTaskSwitchedIn() with interrupts disabled.
+static uint32_t s_switchTaskCycles[CONTROLLER_RUNNER_MAX_TASKS];
+static uint32_t s_switchIdleCycles = 0;
+static uint32_t s_switchOtherCycles = 0;
+static uint32_t* s_runningBucket = nullptr;
+static uint32_t s_lastSwitchCycles = 0;
+static TaskHandle_t s_idleHandle = NULL;
+
+// Counters at the previous getCpuLoad() call.
+static uint32_t s_loadWindowStartCycles = 0;
+static uint32_t s_loadSwitchTaskCycles[CONTROLLER_RUNNER_MAX_TASKS];
+static uint32_t s_loadSwitchIdleCycles = 0;
+static uint32_t s_loadSwitchOtherCycles = 0;
+#endif
+
+/**
+ * @brief Returns the index of the entry that creates the FreeRTOS task for entry i.
+ * Ungrouped entries are their own leader; grouped entries share the first entry of their group.
+ */
+static size_t group_leader(size_t i)
+{
+    uint8_t group = s_tasks[i].config->group;
+    if (group != 0)
+    {
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (s_tasks[j].config->group == group)
+            {
+                return j;
+            }
+        }
+    }
+    return i;
+}
+
+/**
+ * @brief Returns the current period of a task. TickType_t is wider than one byte on AVR,
+ * so the read must not be torn by setTaskPeriod() running in another task.
+ */
+static TickType_t current_period(const TaskRuntime* runtime)
+{
+    taskENTER_CRITICAL();
+    TickType_t delayTicks = runtime->delayTicks;
+    taskEXIT_CRITICAL();
+    return delayTicks;
+}
+
+/**
+ * @brief Returns the EEPROM address of the tuning block of entry i.
+ */
+static uint16_t tuning_address(size_t i)
+{
+    return s_tuningAddress + i * EepromService::blockSize<TaskTuning>(s_tuningSlots);
+}
+
+/**
+ * @brief Saves the current period and priority of entry i, if persistence is enabled.
+ * Deferred with writeBehind(): an HA number sends a command per step, only the value it
+ * settles on is written.
+ */
+static void save_tuning(size_t i)
+{
+    if (!s_tuningPersisted)
+    {
+        return;
+    }
+
+    TaskTuning tuning = {
+        .configDelayTicks = s_tasks[i].config->delayTicks,
+        .delayTicks = current_period(&s_tasks[i]),
+        .priority = (uint8_t)s_tasks[i].priority
+    };
+    EepromService::writeBehind<TaskTuning>(tuning_address(i), tuning, s_tuningSlots);
+}
+
+/**
+ * @brief Restores the period and priority of entry i saved by a previous boot.
+ */
+static void load_tuning(size_t i)
+{
+    const TaskConfig* config = s_tasks[i].config;
+    TaskTuning defaults = {
+        .configDelayTicks = config->delayTicks,
+        .delayTicks = config->delayTicks,
+        .priority = (uint8_t)config->priority
+    };
+    TaskTuning tuning = EepromService::read<TaskTuning>(tuning_address(i), defaults, s_tuningSlots);
+
+    // A record written for another compile-time period belongs to an older task table.
+    if (tuning.configDelayTicks != config->delayTicks || tuning.delayTicks == 0 ||
+        tuning.priority >= configMAX_PRIORITIES)
+    {
+        return;
+    }
+    s_tasks[i].delayTicks = tuning.delayTicks;
+    s_tasks[i].priority = tuning.priority;
+}
+
+/**
+ * @brief Records the duration of one loopFunc call and reports a budget overrun if needed.
+ * @param executionTicks ProfilingClock cycles with PROFILINGCLOCK, microseconds otherwise.
+ */
+static void record_execution(TaskRuntime* runtime, uint32_t executionTicks)
+{
+#ifdef PROFILINGCLOCK
+    const uint8_t cyclesPerUs = F_CPU / 1000000UL;
+    uint32_t executionUs = ProfilingClock::cyclesToUs(executionTicks);
+    bool overrun = runtime->config->budgetUs != 0 && executionTicks > runtime->config->budgetUs * cyclesPerUs;
+#else
+    uint32_t executionUs = executionTicks;
+    bool overrun = runtime->config->budgetUs != 0 && executionUs > runtime->config->budgetUs;
+#endif
+
+    taskENTER_CRITICAL();
+    runtime->stats.iterations++;
+    runtime->stats.lastExecutionUs = executionUs;
+    if (executionUs > runtime->stats.maxExecutionUs) runtime->stats.maxExecutionUs = executionUs;
+#ifdef PROFILINGCLOCK
+    // The total is summed in cycles, so calls shorter than a microsecond still add up.
+    uint32_t cycles = runtime->totalRemainderCycles + executionTicks;
+    runtime->stats.totalExecutionUs += cycles / cyclesPerUs;
+    runtime->totalRemainderCycles = cycles % cyclesPerUs;
+#else
+    runtime->stats.totalExecutionUs += executionUs;
+#endif
+    if (overrun) runtime->stats.budgetOverruns++;
+    taskEXIT_CRITICAL();
+
+    if (overrun && s_overrunCallback)
+    {
+        s_overrunCallback(runtime - s_tasks, TaskOverrun::BUDGET_OVERRUN, executionUs);
+    }
+}
+
+/**
+ * @brief Records a late PERIODIC wakeup.
+ */
+static void record_deadline_miss(TaskRuntime* runtime)
+{
+    taskENTER_CRITICAL();
+    runtime->stats.deadlineMisses++;
+    taskEXIT_CRITICAL();
+
+    if (s_overrunCallback)
+    {
+        s_overrunCallback(runtime - s_tasks, TaskOverrun::DEADLINE_MISS, runtime->stats.lastExecutionUs);
+    }
+}
+
+/**
+ * @brief Runs one iteration of a task's loopFunc with measurement and busy tracking.
+ * @param runtime The runtime entry of the task (or group member) to run.
+ */
+static void run_iteration(TaskRuntime* runtime)
+{
+    const TaskConfig* config = runtime->config;
+
+    runtime->heartbeat = xTaskGetTickCount();
+    runtime->inLoop = true;
+
+#ifdef TASKMONITOR
+    // Begin measurement if a monitor is assigned.
+    if(config->monitor) config->monitor->beginMeasurement();
+#endif
+
+    // Execute the main loop function if it exists.
+    if (config->loopFunc)
+    {
+#ifdef PROFILINGCLOCK
+        uint32_t startCycles = ProfilingClock::now();
+        config->loopFunc();
+        record_execution(runtime, ProfilingClock::now() - startCycles);
+#else
+        unsigned long startUs = micros();
+        config->loopFunc();
+        record_execution(runtime, micros() - startUs);
+#endif
+    }
+
+    if (config->delayType == DelayType::ADAPTIVE)
+    {
+        runtime->busy = config->isBusyFunc != nullptr && config->isBusyFunc();
+    }
+
+    runtime->heartbeat = xTaskGetTickCount();
+    runtime->inLoop = false;
+
+#ifdef TASKMONITOR
+    // End measurement and report if a monitor is assigned.
+    if(config->monitor) {
+        config->monitor->endMeasurement();
+        config->monitor->report();
+    }
+#endif
+}
+
 /**
  * @brief A generic task function (wrapper) used by FreeRTOS to run all configured tasks.
- * @param pvParameters A void pointer to a TaskConfig struct for this specific task.
+ * @param pvParameters A void pointer to the TaskRuntime entry of this specific task.
  */
 static void generic_task_wrapper(void* pvParameters)
 {
-    // Cast the parameter back to a pointer to its TaskConfig struct.
-    const TaskConfig* config = static_cast<const TaskConfig*>(pvParameters);
+    // Cast the parameter back to its runtime entry and configuration.
+    TaskRuntime* runtime = static_cast<TaskRuntime*>(pvParameters);
+    const TaskConfig* config = runtime->config;
 
     // 1. Run the one-time setup function if it exists.
     if (config->setupFunc)
     {
+        BOOT_PROFILE_SCOPE(F("setupFunc"), config->name);
         config->setupFunc();
     }
+    runtime->heartbeat = xTaskGetTickCount();
+    runtime->started = true;
 
     // Prepare for the periodic delay loop if needed.
     TickType_t xLastWakeTime;
-    if (config->delayType == DelayType::PERIODIC)
+    if (config->delayType == DelayType::PERIODIC || config->delayType == DelayType::ADAPTIVE)
     {
         xLastWakeTime = xTaskGetTickCount();
     }
 
+    const TickType_t fastDelayTicks = config->fastDelayTicks > 0 ? config->fastDelayTicks : 1;
+
     // 2. Enter the infinite task loop.
     for (;;)
     {
         // Choose the appropriate delay type based on the configuration.
         if (config->delayType == DelayType::PERIODIC)
         {
-            vTaskDelayUntil(&xLastWakeTime, config->delayTicks);
+            // xTaskDelayUntil returns pdFALSE when the release time has already passed,
+            // i.e. the previous iteration overran its period.
+            if (xTaskDelayUntil(&xLastWakeTime, current_period(runtime)) == pdFALSE)
+            {
+                record_deadline_miss(runtime);
+            }
+        }
+        else if (config->delayType == DelayType::ADAPTIVE)
+        {
+            if (runtime->busy)
+            {
+                // Device is active: run at the fast rate with the same deadline tracking as PERIODIC.
+                if (xTaskDelayUntil(&xLastWakeTime, fastDelayTicks) == pdFALSE)
+                {
+                    record_deadline_miss(runtime);
+                }
+            }
+            else
+            {
+                // Idle: sleep for the slow period, a notification switches back to work immediately.
+                ulTaskNotifyTake(pdTRUE, current_period(runtime));
+                xLastWakeTime = xTaskGetTickCount();
+            }
+        }
+        else if (config->delayType == DelayType::EVENT)
+        {
+            // Sleep until notify()/notifyFromISR() or the timeout; collapse multiple notifications.
+            ulTaskNotifyTake(pdTRUE, current_period(runtime));
         }
         else
         {
             // DelayType::SIMPLE
-            vTaskDelay(config->delayTicks);
+            vTaskDelay(current_period(runtime));
         }
 
-#ifdef DEBUGSTACK
-        // Begin measurement if a monitor is assigned.
-        if(config->monitor) config->monitor->beginMeasurement();
-#endif
+        run_iteration(runtime);
+    }
+}
+
+/**
+ * @brief Returns true once the tick counter has reached the target, wrap-around safe.
+ */
+static bool tick_reached(TickType_t now, TickType_t target)
+{
+    return (TickType_t)(now - target) < (TickType_t)(((TickType_t)~(TickType_t)0) >> 1);
+}
+
+/**
+ * @brief Returns true if a group member has no upper bound on its sleep (EVENT forever / idle ADAPTIVE forever).
+ */
+static bool waits_forever(const TaskRuntime* member)
+{
+    const TaskConfig* config = member->config;
+    bool eventLike = config->delayType == DelayType::EVENT ||
+        (config->delayType == DelayType::ADAPTIVE && !member->busy);
+    return eventLike && current_period(member) == portMAX_DELAY;
+}
+
+/**
+ * @brief Computes the next release time of a group member after it has run.
+ * PERIODIC (and busy ADAPTIVE) members keep a fixed grid like xTaskDelayUntil, and a
+ * release time that is already in the past counts as a deadline miss.
+ */
+static void schedule_next(TaskRuntime* member, bool wasBusy)
+{
+    const TaskConfig* config = member->config;
+    TickType_t now = xTaskGetTickCount();
 
-        // Execute the main loop function if it exists.
-        if (config->loopFunc)
+    if (config->delayType == DelayType::PERIODIC ||
+        (config->delayType == DelayType::ADAPTIVE && member->busy))
+    {
+        TickType_t period = current_period(member);
+        if (config->delayType == DelayType::ADAPTIVE)
         {
-            config->loopFunc();
+            period = config->fastDelayTicks > 0 ? config->fastDelayTicks : 1;
+            if (!wasBusy)
+            {
+                // Leaving idle: start a new grid from now.
+                member->nextWake = now;
+            }
         }
 
-#ifdef DEBUGSTACK
-        // End measurement and report if a monitor is assigned.
-        if(config->monitor) {
-            config->monitor->endMeasurement();
-            config->monitor->report();
+        member->nextWake += period;
+        if (tick_reached(now, member->nextWake))
+        {
+            record_deadline_miss(member);
         }
+    }
+    else
+    {
+        // SIMPLE, EVENT and idle ADAPTIVE: relative to the end of this iteration.
+        member->nextWake = now + current_period(member);
+    }
+}
+
+/**
+ * @brief Task function for a group of TaskConfig entries sharing one FreeRTOS task.
+ * Members run cooperatively whenever their release time is reached, earliest deadline
+ * (most overdue) first, ties in table order; a notification releases all EVENT and idle
+ * ADAPTIVE members of the group at once.
+ * @param pvParameters A void pointer to the TaskRuntime entry of the group leader.
+ */
+static void group_task_wrapper(void* pvParameters)
+{
+    TaskRuntime* leader = static_cast<TaskRuntime*>(pvParameters);
+    const uint8_t group = leader->config->group;
+    TaskRuntime* const end = s_tasks + s_taskCount;
+
+    // 1. Run all setup functions of the group, then place every member on its first release time.
+    for (TaskRuntime* member = leader; member < end; ++member)
+    {
+        if (member->config->group == group && member->config->setupFunc)
+        {
+            BOOT_PROFILE_SCOPE(F("setupFunc"), member->config->name);
+            member->config->setupFunc();
+        }
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    for (TaskRuntime* member = leader; member < end; ++member)
+    {
+        if (member->config->group == group)
+        {
+            member->nextWake = now + current_period(member);
+            member->heartbeat = now;
+            member->started = true;
+        }
+    }
+
+    // 2. Sleep until the earliest release time (or a notification), then run every due member.
+    for (;;)
+    {
+        now = xTaskGetTickCount();
+        TickType_t sleepTicks = portMAX_DELAY;
+        for (TaskRuntime* member = leader; member < end; ++member)
+        {
+            if (member->config->group != group || waits_forever(member))
+            {
+                continue;
+            }
+
+            TickType_t remaining = tick_reached(now, member->nextWake) ? 0 : (TickType_t)(member->nextWake - now);
+            if (remaining < sleepTicks)
+            {
+                sleepTicks = remaining;
+            }
+        }
+
+        bool notified = ulTaskNotifyTake(pdTRUE, sleepTicks) > 0;
+
+        // Collect the due members, ordered by how long their release time has passed.
+        TaskRuntime* due[CONTROLLER_RUNNER_MAX_TASKS];
+        TickType_t lateness[CONTROLLER_RUNNER_MAX_TASKS];
+        uint8_t dueCount = 0;
+        now = xTaskGetTickCount();
+        for (TaskRuntime* member = leader; member < end; ++member)
+        {
+            if (member->config->group != group)
+            {
+                continue;
+            }
+
+            const TaskConfig* config = member->config;
+            bool eventLike = config->delayType == DelayType::EVENT ||
+                (config->delayType == DelayType::ADAPTIVE && !member->busy);
+            bool released = !waits_forever(member) && tick_reached(now, member->nextWake);
+            if (!released && !(notified && eventLike))
+            {
+                continue;
+            }
+
+            TickType_t late = released ? (TickType_t)(now - member->nextWake) : 0;
+            uint8_t position = dueCount++;
+            while (position > 0 && lateness[position - 1] < late)
+            {
+                due[position] = due[position - 1];
+                lateness[position] = lateness[position - 1];
+                --position;
+            }
+            due[position] = member;
+            lateness[position] = late;
+        }
+
+        for (uint8_t i = 0; i < dueCount; ++i)
+        {
+            bool wasBusy = due[i]->busy;
+            run_iteration(due[i]);
+            schedule_next(due[i], wasBusy);
+        }
+    }
+}
+
+/**
+ * @brief Returns true if the task has missed its heartbeat by more than the supervisor timeout.
+ */
+static bool is_hung(const TaskRuntime* runtime, TickType_t now)
+{
+    if (!runtime->started || runtime->handle == NULL)
+    {
+        return false;
+    }
+
+    TickType_t sinceHeartbeat = now - runtime->heartbeat;
+    if (runtime->inLoop)
+    {
+        return sinceHeartbeat > s_supervisorTimeoutTicks;
+    }
+
+    // Sleeping: only bounded sleeps have a deadline (EVENT/ADAPTIVE may wait forever).
+    TickType_t maxSleep = current_period(runtime);
+    if (maxSleep == portMAX_DELAY)
+    {
+        return false;
+    }
+    return sinceHeartbeat > maxSleep + s_supervisorTimeoutTicks;
+}
+
+/**
+ * @brief Supervisor task: checks all heartbeats and feeds the hardware watchdog while everything is alive.
+ */
+static void supervisor_task(void*)
+{
+#ifndef portUSE_WDTO
+    wdt_enable(WDTO_2S);
+#endif
+
+    // A quarter of the timeout, but often enough to feed the 2 s watchdog with a wide margin.
+    const TickType_t maxCheckPeriod = pdMS_TO_TICKS(500) > 0 ? pdMS_TO_TICKS(500) : 1;
+    TickType_t checkPeriod = s_supervisorTimeoutTicks / 4 > 0 ? s_supervisorTimeoutTicks / 4 : 1;
+    if (checkPeriod > maxCheckPeriod)
+    {
+        checkPeriod = maxCheckPeriod;
+    }
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    for (;;)
+    {
+        vTaskDelayUntil(&xLastWakeTime, checkPeriod);
+
+        TickType_t now = xTaskGetTickCount();
+        for (size_t i = 0; i < s_taskCount; ++i)
+        {
+            if (is_hung(&s_tasks[i], now))
+            {
+                EPRINT(F("ERROR: Task hung: "));
+                EPRINTLN(s_tasks[i].config->name);
+#ifdef TRACEPOINTS
+                // The last tracepoints show what the devices were doing before the hang.
+                Tracepoint::dump(LOG_SERIAL);
+                LOG_SERIAL.flush();
+#endif
+                ControllerRunner::enterSafeStateAndReset();
+            }
+        }
+
+#ifndef portUSE_WDTO
+        wdt_reset();
 #endif
     }
 }
 
+#if EEPROM_SERVICE_CACHE_SIZE > 0 && CONTROLLER_RUNNER_PERSIST_STACK_SIZE > 0
+/**
+ * @brief Persistence task: writes EepromService::writeBehind() values once they are quiet.
+ * Lowest task priority, so the writes only take CPU time the device tasks do not need.
+ */
+static void persist_task(void*)
+{
+    const TickType_t period = pdMS_TO_TICKS(CONTROLLER_RUNNER_PERSIST_PERIOD_MS) > 0
+                                  ? pdMS_TO_TICKS(CONTROLLER_RUNNER_PERSIST_PERIOD_MS)
+                                  : 1;
+    for (;;)
+    {
+        vTaskDelay(period);
+        EepromService::flushDue();
+    }
+}
+#endif
+
 void ControllerRunner::run(const TaskConfig tasks[], size_t taskCount)
 {
-#if defined(DEBUG) || defined(DEBUGSTACK)
-    Serial.begin(9600);
+#if defined(LOGGING) || defined(DEBUGSTACK) || defined(TRACE) || defined(TRACEPOINTS)
+    LOG_SERIAL.begin(DEBUG_SERIAL_BAUD);
 #endif
 
 #ifdef DEBUGSTACK
-    // Create the mutex semaphore before starting the scheduler.
-    g_serialSemaphore = xSemaphoreCreateMutex();
+    // Drain task for SDPRINT output queued by TaskMonitor and other tasks.
+    if (!DeferredLog::begin())
+    {
+        EPRINTLN(F("ERROR: Could not create log task"));
+    }
+#endif
+
+    // Before the task stacks are allocated, so the whole gap is painted.
+    MemoryMonitor::begin();
+
+#ifdef PROFILINGCLOCK
+    ProfilingClock::begin();
 #endif
 
     DPRINTLN(F("ControllerRunner: Creating tasks..."));
 
+    if (taskCount > CONTROLLER_RUNNER_MAX_TASKS)
+    {
+        EPRINTLN(F("ERROR: Too many tasks, increase CONTROLLER_RUNNER_MAX_TASKS"));
+        taskCount = CONTROLLER_RUNNER_MAX_TASKS;
+    }
+    s_taskCount = taskCount;
+
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        s_tasks[i] = TaskRuntime{};
+        s_tasks[i].config = &tasks[i];
+        s_tasks[i].delayTicks = tasks[i].delayTicks;
+        s_tasks[i].priority = tasks[i].priority;
+        if (s_tuningPersisted)
+        {
+            load_tuning(i);
+        }
+    }
+
     // Iterate through all provided task configurations.
     for (size_t i = 0; i < taskCount; ++i)
     {
+        // Group members after the first one run inside the task of their group leader.
+        if (group_leader(i) != i)
+        {
+            continue;
+        }
+
         DPRINT(F("Creating task: "));
         DPRINTLN(tasks[i].name);
 
+        TaskFunction_t taskFunction = tasks[i].group != 0 ? group_task_wrapper : generic_task_wrapper;
+
         TaskHandle_t taskHandle = NULL; // Handle to the created task.
+        BaseType_t created;
 
-        xTaskCreate(
-            generic_task_wrapper,
-            tasks[i].name,
-            tasks[i].stackSize,
-            (void*)&tasks[i], // Pass a pointer to this task's specific configuration.
-            tasks[i].priority,
-            &taskHandle // Capture the handle of the created task.
-        );
+#if configSUPPORT_STATIC_ALLOCATION == 1
+        if (tasks[i].stackBuffer != nullptr && tasks[i].tcbBuffer != nullptr)
+        {
+            // Static mode: stack and TCB live in .bss, nothing is taken from the heap.
+            taskHandle = xTaskCreateStatic(
+                taskFunction,
+                tasks[i].name,
+                tasks[i].stackSize,
+                (void*)&s_tasks[i],
+                s_tasks[i].priority,
+                tasks[i].stackBuffer,
+                tasks[i].tcbBuffer
+            );
+            created = (taskHandle != NULL) ? pdPASS : pdFAIL;
+        }
+        else
+#endif
+        {
+            created = xTaskCreate(
+                taskFunction,
+                tasks[i].name,
+                tasks[i].stackSize,
+                (void*)&s_tasks[i], // Pass a pointer to this task's runtime entry.
+                s_tasks[i].priority,
+                &taskHandle // Capture the handle of the created task.
+            );
+        }
 
-#ifdef DEBUGSTACK
+        if (created != pdPASS)
+        {
+            // Most likely the heap is exhausted; the remaining tasks may still fit.
+            EPRINT(F("ERROR: Could not create task: "));
+            EPRINTLN(tasks[i].name);
+            continue;
+        }
+        s_tasks[i].handle = taskHandle;
+    }
+
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        // Group members share the handle (and stack) of their leader.
+        s_tasks[i].handle = s_tasks[group_leader(i)].handle;
+
+#ifdef TASKMONITOR
         // If a monitor exists for this task, assign its handle.
-        if (tasks[i].monitor != nullptr && taskHandle != NULL) {
-            tasks[i].monitor->setTaskHandle(taskHandle);
+        if (tasks[i].monitor != nullptr && s_tasks[i].handle != NULL) {
+            tasks[i].monitor->setTaskHandle(s_tasks[i].handle);
         }
 #endif
     }
 
+    if (s_supervisorTimeoutTicks > 0)
+    {
+        // Highest priority, so a spinning task cannot starve the supervisor.
+        if (xTaskCreate(supervisor_task, "SUP", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL) != pdPASS)
+        {
+            EPRINTLN(F("ERROR: Could not create supervisor task"));
+        }
+    }
+
+#if EEPROM_SERVICE_CACHE_SIZE > 0 && CONTROLLER_RUNNER_PERSIST_STACK_SIZE > 0
+    if (xTaskCreate(persist_task, "EEP", CONTROLLER_RUNNER_PERSIST_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+    {
+        EPRINTLN(F("ERROR: Could not create EEPROM task"));
+    }
+#endif
+
     DPRINTLN(F("Starting FreeRTOS scheduler..."));
     vTaskStartScheduler();
 }
+
+void ControllerRunner::notify(size_t taskIndex)
+{
+    if (taskIndex < s_taskCount && s_tasks[taskIndex].handle != NULL)
+    {
+        xTaskNotifyGive(s_tasks[taskIndex].handle);
+    }
+}
+
+void ControllerRunner::notifyFromISR(size_t taskIndex)
+{
+    if (taskIndex < s_taskCount && s_tasks[taskIndex].handle != NULL)
+    {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(s_tasks[taskIndex].handle, &higherPriorityTaskWoken);
+        if (higherPriorityTaskWoken == pdTRUE)
+        {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+TaskHandle_t ControllerRunner::getTaskHandle(size_t taskIndex)
+{
+    return taskIndex < s_taskCount ? s_tasks[taskIndex].handle : NULL;
+}
+
+void ControllerRunner::onOverrun(TaskOverrunCallback callback)
+{
+    s_overrunCallback = callback;
+}
+
+bool ControllerRunner::getTaskStats(size_t taskIndex, TaskStats& stats)
+{
+    if (taskIndex >= s_taskCount)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    stats = s_tasks[taskIndex].stats;
+    taskEXIT_CRITICAL();
+
+#ifdef TASKMONITOR
+    if (TaskMonitor* monitor = s_tasks[taskIndex].config->monitor; monitor != nullptr)
+    {
+        TaskMonitor::Summary summary = monitor->lastSummary();
+        stats.p50ExecutionNs = summary.p50Ns;
+        stats.p95ExecutionNs = summary.p95Ns;
+        stats.p99ExecutionNs = summary.p99Ns;
+    }
+#endif
+    return true;
+}
+
+void ControllerRunner::resetTaskStats(size_t taskIndex)
+{
+    if (taskIndex < s_taskCount)
+    {
+        taskENTER_CRITICAL();
+        s_tasks[taskIndex].stats = TaskStats{};
+        taskEXIT_CRITICAL();
+    }
+}
+
+bool ControllerRunner::setTaskPeriod(size_t taskIndex, TickType_t delayTicks)
+{
+    if (taskIndex >= s_taskCount || delayTicks == 0)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    s_tasks[taskIndex].delayTicks = delayTicks;
+    taskEXIT_CRITICAL();
+
+    save_tuning(taskIndex);
+    return true;
+}
+
+TickType_t ControllerRunner::getTaskPeriod(size_t taskIndex)
+{
+    return taskIndex < s_taskCount ? current_period(&s_tasks[taskIndex]) : 0;
+}
+
+#ifdef TASKMONITOR
+TaskMonitor* ControllerRunner::getTaskMonitor(size_t taskIndex)
+{
+    return taskIndex < s_taskCount ? s_tasks[taskIndex].config->monitor : nullptr;
+}
+#endif
+
+bool ControllerRunner::setTaskPriority(size_t taskIndex, UBaseType_t priority)
+{
+    if (taskIndex >= s_taskCount || priority >= configMAX_PRIORITIES)
+    {
+        return false;
+    }
+
+    // The priority belongs to the FreeRTOS task, i.e. to the group leader.
+    size_t leader = group_leader(taskIndex);
+    s_tasks[leader].priority = priority;
+    if (s_tasks[leader].handle != NULL)
+    {
+        vTaskPrioritySet(s_tasks[leader].handle, priority);
+    }
+
+    save_tuning(leader);
+    return true;
+}
+
+UBaseType_t ControllerRunner::getTaskPriority(size_t taskIndex)
+{
+    return taskIndex < s_taskCount ? s_tasks[group_leader(taskIndex)].priority : 0;
+}
+
+void ControllerRunner::enableTuningPersistence(uint16_t eepromAddress, uint8_t slots)
+{
+    s_tuningPersisted = true;
+    s_tuningAddress = eepromAddress;
+    s_tuningSlots = slots > 0 ? slots : 1;
+}
+
+void ControllerRunner::enableSupervisor(uint16_t timeoutMs)
+{
+    s_supervisorTimeoutTicks = pdMS_TO_TICKS(timeoutMs) > 0 ? pdMS_TO_TICKS(timeoutMs) : 1;
+}
+
+bool ControllerRunner::addSafeStateHook(SafeStateHook hook)
+{
+    if (s_safeStateHookCount >= CONTROLLER_RUNNER_MAX_SAFE_STATE_HOOKS)
+    {
+        return false;
+    }
+    s_safeStateHooks[s_safeStateHookCount++] = hook;
+    return true;
+}
+
+void ControllerRunner::enterSafeStateAndReset()
+{
+    // Keep every other task away from the hardware while the hooks run.
+    vTaskSuspendAll();
+
+    for (uint8_t i = 0; i < s_safeStateHookCount; ++i)
+    {
+        s_safeStateHooks[i]();
+    }
+
+    // Persist what the write-behind cache still holds, including values stored by the hooks.
+    EepromService::flush();
+
+    // Switch the watchdog to system reset mode and wait for it to fire.
+    portDISABLE_INTERRUPTS();
+    wdt_enable(WDTO_15MS);
+    for (;;)
+    {
+    }
+}
+
+/**
+ * @brief Returns part/whole in permille without 64-bit math, clamped to 1000.
+ */
+static uint16_t to_permille(uint32_t part, uint32_t whole)
+{
+    if (whole < 1000)
+    {
+        return 0;
+    }
+    uint32_t permille = part / (whole / 1000);
+    return permille > 1000 ? 1000 : (uint16_t)permille;
+}
+
+#ifdef CPUSTATS
+/**
+ * @brief Returns the counter charged while the given task runs.
+ */
+static uint32_t* bucket_of(TaskHandle_t handle)
+{
+    for (size_t i = 0; i < s_taskCount; ++i)
+    {
+        if (s_tasks[i].handle == handle)
+        {
+            // Group members share the handle of their leader, which comes first.
+            return &s_switchTaskCycles[i];
+        }
+    }
+
+    if (handle == s_idleHandle)
+    {
+        return &s_switchIdleCycles;
+    }
+    if (s_idleHandle == NULL && strcmp(pcTaskGetName(handle), configIDLE_TASK_NAME) == 0)
+    {
+        s_idleHandle = handle;
+        return &s_switchIdleCycles;
+    }
+    return &s_switchOtherCycles;
+}
+
+/**
+ * @brief Charges the cycles since the previous switch to the task that was running.
+ * Interrupts must be disabled.
+ */
+static void charge_running_task(uint32_t now)
+{
+    if (s_runningBucket != nullptr)
+    {
+        *s_runningBucket += now - s_lastSwitchCycles;
+    }
+    s_lastSwitchCycles = now;
+}
+
+// FreeRTOS traceTASK_SWITCHED_IN() hook, installed by the "cpustats" env in platformio.ini.
+// Runs in the kernel with interrupts disabled, right after pxCurrentTCB has changed.
+extern "C" void vControllerRunnerTaskSwitchedIn()
+{
+    charge_running_task(ProfilingClock::now());
+    s_runningBucket = bucket_of(xTaskGetCurrentTaskHandle());
+}
+
+void ControllerRunner::getCpuLoad(CpuLoad& load)
+{
+    uint32_t taskCycles[CONTROLLER_RUNNER_MAX_TASKS];
+    uint32_t idleCycles;
+    uint32_t otherCycles;
+
+    taskENTER_CRITICAL();
+    uint32_t now = ProfilingClock::now();
+    charge_running_task(now);
+    for (size_t i = 0; i < s_taskCount; ++i)
+    {
+        taskCycles[i] = s_switchTaskCycles[i] - s_loadSwitchTaskCycles[i];
+        s_loadSwitchTaskCycles[i] = s_switchTaskCycles[i];
+    }
+    idleCycles = s_switchIdleCycles - s_loadSwitchIdleCycles;
+    s_loadSwitchIdleCycles = s_switchIdleCycles;
+    otherCycles = s_switchOtherCycles - s_loadSwitchOtherCycles;
+    s_loadSwitchOtherCycles = s_switchOtherCycles;
+    taskEXIT_CRITICAL();
+
+    uint32_t windowCycles = now - s_loadWindowStartCycles;
+    s_loadWindowStartCycles = now;
+    load.windowUs = ProfilingClock::cyclesToUs(windowCycles);
+    load.taskCount = s_taskCount;
+    load.idlePermille = to_permille(idleCycles, windowCycles);
+    load.otherPermille = to_permille(otherCycles, windowCycles);
+
+    // loopFunc time of every entry, to split the time of a shared group task.
+    uint32_t loopUs[CONTROLLER_RUNNER_MAX_TASKS];
+    for (size_t i = 0; i < s_taskCount; ++i)
+    {
+        taskENTER_CRITICAL();
+        uint32_t totalUs = s_tasks[i].stats.totalExecutionUs;
+        taskEXIT_CRITICAL();
+        loopUs[i] = totalUs - s_loadTaskUs[i];
+        s_loadTaskUs[i] = totalUs;
+    }
+
+    for (size_t i = 0; i < s_taskCount; ++i)
+    {
+        size_t leader = group_leader(i);
+        uint16_t groupPermille = to_permille(taskCycles[leader], windowCycles);
+        if (s_tasks[i].config->group == 0)
+        {
+            load.taskPermille[i] = groupPermille;
+            continue;
+        }
+
+        uint32_t groupLoopUs = 0;
+        for (size_t j = leader; j < s_taskCount; ++j)
+        {
+            if (group_leader(j) == leader)
+            {
+                groupLoopUs += loopUs[j];
+            }
+        }
+        load.taskPermille[i] = groupLoopUs > 0 ? (uint16_t)((float)groupPermille * loopUs[i] / groupLoopUs) : 0;
+    }
+
+    taskENTER_CRITICAL();
+    uint32_t idleHookCalls = s_idleHookCalls;
+    taskEXIT_CRITICAL();
+    load.idleHookCalls = idleHookCalls - s_loadIdleHookCalls;
+    s_loadIdleHookCalls = idleHookCalls;
+}
+#else
+void ControllerRunner::getCpuLoad(CpuLoad& load)
+{
+    uint32_t nowUs = micros();
+    load.windowUs = nowUs - s_loadWindowStartUs;
+    load.taskCount = s_taskCount;
+    s_loadWindowStartUs = nowUs;
+
+    uint32_t busyUs = 0;
+    for (size_t i = 0; i < s_taskCount; ++i)
+    {
+        taskENTER_CRITICAL();
+        uint32_t totalUs = s_tasks[i].stats.totalExecutionUs;
+        taskEXIT_CRITICAL();
+
+        uint32_t taskUs = totalUs - s_loadTaskUs[i];
+        s_loadTaskUs[i] = totalUs;
+        busyUs += taskUs;
+        load.taskPermille[i] = to_permille(taskUs, load.windowUs);
+    }
+
+    // Approximate: other tasks and time lost to preemption count as idle.
+    uint32_t idleUs = busyUs < load.windowUs ? load.windowUs - busyUs : 0;
+    load.idlePermille = to_permille(idleUs, load.windowUs);
+    load.otherPermille = 0;
+
+    taskENTER_CRITICAL();
+    uint32_t idleHookCalls = s_idleHookCalls;
+    taskEXIT_CRITICAL();
+    load.idleHookCalls = idleHookCalls - s_loadIdleHookCalls;
+    s_loadIdleHookCalls = idleHookCalls;
+}
+#endif
+
+void ControllerRunner::idleHook()
+{
+    taskENTER_CRITICAL();
+    s_idleHookCalls++;
+    taskEXIT_CRITICAL();
+}
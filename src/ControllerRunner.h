@@ -5,12 +5,37 @@
 #include <Arduino_FreeRTOS.h>
 #include <Debug.h>
 
+#include "EepromSerivce.h"
+
 // Forward-declare TaskMonitor to avoid circular dependencies if needed,
 // but including it directly is fine here.
-#ifdef DEBUGSTACK
+#ifdef TASKMONITOR
 #include "TaskMonitor.h"
 #endif
 
+// Maximum number of entries in the task table passed to ControllerRunner::run().
+#ifndef CONTROLLER_RUNNER_MAX_TASKS
+#define CONTROLLER_RUNNER_MAX_TASKS 8
+#endif
+
+// Maximum number of hooks registered with ControllerRunner::addSafeStateHook().
+#ifndef CONTROLLER_RUNNER_MAX_SAFE_STATE_HOOKS
+#define CONTROLLER_RUNNER_MAX_SAFE_STATE_HOOKS 4
+#endif
+
+// Stack of the "EEP" task that writes due EepromService::writeBehind() values, 0 disables it.
+// The task only exists with EEPROM_SERVICE_CACHE_SIZE > 0.
+// The deepest path (flushDue -> _persist -> write -> _scan -> EepromWriter::read) with a
+// 24-byte value takes ~280 bytes including the context saved on a switch.
+#ifndef CONTROLLER_RUNNER_PERSIST_STACK_SIZE
+#define CONTROLLER_RUNNER_PERSIST_STACK_SIZE 384
+#endif
+
+// Period of the "EEP" task, bounds how late a quiet writeBehind() value is written.
+#ifndef CONTROLLER_RUNNER_PERSIST_PERIOD_MS
+#define CONTROLLER_RUNNER_PERSIST_PERIOD_MS 100
+#endif
+
 /**
  * @enum DelayType
  * @brief Specifies the type of delay to use within a task's loop.
@@ -18,9 +43,94 @@
 enum class DelayType
 {
     PERIODIC, // Use vTaskDelayUntil for precise, periodic execution.
-    SIMPLE // Use vTaskDelay for a simple, non-blocking delay.
+    SIMPLE, // Use vTaskDelay for a simple, non-blocking delay.
+    EVENT, // Block until notified (see ControllerRunner::notify), delayTicks is the max timeout.
+    ADAPTIVE // Periodic at fastDelayTicks while isBusyFunc() is true, otherwise like EVENT with delayTicks.
+};
+
+/**
+ * @enum TaskOverrun
+ * @brief Kind of timing violation reported through ControllerRunner::onOverrun().
+ */
+enum class TaskOverrun
+{
+    DEADLINE_MISS, // A PERIODIC task woke up after its next release time had already passed.
+    BUDGET_OVERRUN // loopFunc ran longer than TaskConfig::budgetUs.
+};
+
+/**
+ * @struct TaskStats
+ * @brief Timing counters kept by the runner for every task, available in all builds.
+ */
+struct TaskStats
+{
+    uint32_t iterations; // Completed loopFunc calls.
+    uint16_t deadlineMisses; // Late PERIODIC wakeups.
+    uint16_t budgetOverruns; // loopFunc calls longer than budgetUs.
+    uint32_t lastExecutionUs; // Duration of the most recent loopFunc call.
+    uint32_t maxExecutionUs; // Longest loopFunc call since boot or the last reset.
+    uint32_t totalExecutionUs; // Sum of all loopFunc calls, wraps after ~71 minutes of CPU time.
+
+    // loopFunc time percentiles over the last report interval of the task's TaskMonitor,
+    // 0 without a monitor (TaskConfig::monitor, DEBUGSTACK or TASKDIAGNOSTICS builds).
+    uint32_t p50ExecutionNs;
+    uint32_t p95ExecutionNs;
+    uint32_t p99ExecutionNs;
+};
+
+/**
+ * @struct CpuLoad
+ * @brief CPU usage over the window since the previous ControllerRunner::getCpuLoad() call.
+ * Loads are in permille (1000 = 100%).
+ */
+struct CpuLoad
+{
+    uint32_t windowUs; // Length of the measurement window.
+    uint8_t taskCount; // Number of valid entries in taskPermille.
+    uint16_t taskPermille[CONTROLLER_RUNNER_MAX_TASKS]; // Per task table entry, see getCpuLoad().
+    uint16_t idlePermille; // Time spent in the idle task (the remainder without CPUSTATS).
+    uint16_t otherPermille; // Tasks outside the table (SUP, EEP, LOG, bus tasks), 0 without CPUSTATS.
+    uint32_t idleHookCalls; // ControllerRunner::idleHook() calls in the window.
+};
+
+/**
+ * @struct TaskTuning
+ * @brief Runtime period and priority of a task as persisted in EEPROM.
+ * The compile-time period is stored alongside, so a record is dropped once the firmware
+ * changes that entry's TaskConfig::delayTicks (or the table is reordered).
+ */
+struct TaskTuning
+{
+    TickType_t configDelayTicks; // TaskConfig::delayTicks at the time of writing.
+    TickType_t delayTicks;
+    uint8_t priority;
 };
 
+// Called from the offending task itself, keep it short.
+typedef void (*TaskOverrunCallback)(size_t taskIndex, TaskOverrun kind, uint32_t executionUs);
+
+// Called by the supervisor before a reset; must only touch hardware (no HA/MQTT, no blocking).
+typedef void (*SafeStateHook)();
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+/**
+ * @struct StaticTaskBuffer
+ * @brief Statically allocated stack and TCB for a single task.
+ * Declare one per task at global scope and attach it with withStaticBuffer(), so the memory is
+ * reserved in .bss and an oversized task table fails at link time.
+ * @tparam StackDepth Stack depth in StackType_t words (same unit as TaskConfig::stackSize).
+ */
+template <uint16_t StackDepth>
+struct StaticTaskBuffer
+{
+    static constexpr uint16_t stackDepth = StackDepth;
+    static constexpr size_t ramBytes = StackDepth * sizeof(StackType_t) + sizeof(StaticTask_t);
+
+    StackType_t stack[StackDepth];
+    StaticTask_t tcb;
+};
+#endif
+
 /**
  * @struct TaskConfig
  * @brief Describes a single, complete RTOS task.
@@ -33,14 +143,52 @@ struct TaskConfig
     uint16_t stackSize; // Stack size for the task.
     UBaseType_t priority; // Priority of the task.
     DelayType delayType = DelayType::PERIODIC; // Default delay type.
-    TickType_t delayTicks = pdMS_TO_TICKS(20); // Default delay value.
+    TickType_t delayTicks = pdMS_TO_TICKS(20); // Default delay value (timeout for EVENT, portMAX_DELAY = none).
 
-#ifdef DEBUGSTACK
+#ifdef TASKMONITOR
     // Optional pointer to a monitor instance for this task.
     TaskMonitor* monitor = nullptr;
 #endif
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+    // Optional static memory. When both are set the task is created with xTaskCreateStatic
+    // and stackSize must match the depth of stackBuffer; set all three with withStaticBuffer().
+    StackType_t* stackBuffer = nullptr;
+    StaticTask_t* tcbBuffer = nullptr;
+#endif
+
+    uint32_t budgetUs = 0; // Optional execution budget of one loopFunc call (0 = unlimited).
+
+    // DelayType::ADAPTIVE only. The fast period is clamped to at least one tick.
+    TickType_t fastDelayTicks = 1; // Period used while the task reports busy.
+    // Evaluated after each loopFunc call, e.g. Cover::isAnyTargeting or LedStrip::isAnyBusy.
+    bool (*isBusyFunc)() = nullptr;
+
+    // Entries with the same non-zero group share one FreeRTOS task and run cooperatively,
+    // each on its own delayType/delayTicks schedule. The first entry of a group provides the
+    // task's name, stackSize, priority and static buffers; these fields are ignored for the rest.
+    uint8_t group = 0;
 };
 
+#if configSUPPORT_STATIC_ALLOCATION == 1
+/**
+ * @brief Returns the config with stackSize, stackBuffer and tcbBuffer taken from a
+ * StaticTaskBuffer, so the stack size always matches the buffer:
+ *   static StaticTaskBuffer<256> s_buttonsMemory;
+ *   static const TaskConfig s_tasks[] = {
+ *       withStaticBuffer({"BTN", buttonsSetup, buttonsLoop, 0, 2}, s_buttonsMemory),
+ *   };
+ */
+template <uint16_t StackDepth>
+constexpr TaskConfig withStaticBuffer(TaskConfig config, StaticTaskBuffer<StackDepth>& buffer)
+{
+    config.stackSize = StackDepth;
+    config.stackBuffer = buffer.stack;
+    config.tcbBuffer = &buffer.tcb;
+    return config;
+}
+#endif
+
 namespace ControllerRunner
 {
     /**
@@ -49,6 +197,211 @@ namespace ControllerRunner
      * @param taskCount The number of elements in the tasks array.
      */
     void run(const TaskConfig tasks[], size_t taskCount);
+
+    /**
+     * @brief Wakes a task immediately. Intended for DelayType::EVENT tasks, other tasks ignore it.
+     * For a grouped entry this wakes the whole group.
+     * Safe to call from any task (e.g. HA callbacks), not from an ISR.
+     * @param taskIndex Index of the task in the table passed to run().
+     */
+    void notify(size_t taskIndex);
+
+    /**
+     * @brief ISR-safe variant of notify(), e.g. for pin-change interrupts.
+     * Switches to the woken task on return from the ISR if it has a higher priority.
+     * @param taskIndex Index of the task in the table passed to run().
+     */
+    void notifyFromISR(size_t taskIndex);
+
+    /**
+     * @brief Returns the FreeRTOS handle of a task, or NULL if it was not created.
+     * @param taskIndex Index of the task in the table passed to run().
+     */
+    TaskHandle_t getTaskHandle(size_t taskIndex);
+
+    /**
+     * @brief Registers a callback for deadline misses and budget overruns of any task.
+     * @param callback The function to call, or nullptr to disable.
+     */
+    void onOverrun(TaskOverrunCallback callback);
+
+    /**
+     * @brief Copies the timing counters of a task, with the percentiles of its TaskMonitor.
+     * @param taskIndex Index of the task in the table passed to run().
+     * @param stats Receives the counters.
+     * @return false if the index is out of range.
+     */
+    bool getTaskStats(size_t taskIndex, TaskStats& stats);
+
+    /**
+     * @brief Clears the timing counters of a task.
+     * @param taskIndex Index of the task in the table passed to run().
+     */
+    void resetTaskStats(size_t taskIndex);
+
+    /**
+     * @brief Changes the period of a task at runtime (delayTicks: the period for PERIODIC and
+     * SIMPLE, the timeout for EVENT and the idle period for ADAPTIVE).
+     * The new value is used from the task's next sleep; a task that is already sleeping
+     * finishes its current delay first. Safe to call from any task, e.g. an HA callback.
+     * @param taskIndex Index of the task in the table passed to run().
+     * @param delayTicks The new period, at least one tick (portMAX_DELAY = none for EVENT/ADAPTIVE).
+     * @return false if the index or the period is invalid.
+     */
+    bool setTaskPeriod(size_t taskIndex, TickType_t delayTicks);
+
+    /**
+     * @brief Returns the current period of a task, or 0 if the index is out of range.
+     * @param taskIndex Index of the task in the table passed to run().
+     */
+    TickType_t getTaskPeriod(size_t taskIndex);
+
+#ifdef TASKMONITOR
+    /**
+     * @brief Returns the monitor assigned to a task in its TaskConfig, or nullptr.
+     * @param taskIndex Index of the task in the table passed to run().
+     */
+    TaskMonitor* getTaskMonitor(size_t taskIndex);
+#endif
+
+    /**
+     * @brief Changes the FreeRTOS priority of a task at runtime.
+     * For a grouped entry this changes the priority of the whole group.
+     * @param taskIndex Index of the task in the table passed to run().
+     * @param priority The new priority, below configMAX_PRIORITIES.
+     * @return false if the index or the priority is invalid.
+     */
+    bool setTaskPriority(size_t taskIndex, UBaseType_t priority);
+
+    /**
+     * @brief Returns the current priority of a task (of its group for grouped entries).
+     * @param taskIndex Index of the task in the table passed to run().
+     */
+    UBaseType_t getTaskPriority(size_t taskIndex);
+
+    /**
+     * @brief Persists runtime periods and priorities in EEPROM and restores them in run().
+     * Call before run(). Every task table entry takes one wear-leveled block, see tuningEepromBytes().
+     * Changes are saved with EepromService::writeBehind(), i.e. once they stay unchanged for
+     * EepromService::quietPeriodMs.
+     * @param eepromAddress Start of the EEPROM area reserved for the task table.
+     * @param slots The number of wear-leveling slots per task.
+     */
+    void enableTuningPersistence(uint16_t eepromAddress, uint8_t slots = 4);
+
+    /**
+     * @brief Returns the EEPROM bytes needed by enableTuningPersistence() for a task table.
+     * @param taskCount The number of entries in the task table.
+     * @param slots The number of wear-leveling slots per task.
+     */
+    constexpr uint16_t tuningEepromBytes(size_t taskCount, uint8_t slots = 4)
+    {
+        return taskCount * EepromService::blockSize<TaskTuning>(slots);
+    }
+
+    /**
+     * @brief Enables the task supervisor. Call before run().
+     * A task is considered hung when a loopFunc call runs longer than timeoutMs, or when it has
+     * not completed an iteration within delayTicks + timeoutMs. While all tasks are alive the
+     * supervisor feeds the hardware watchdog; otherwise it runs the safe-state hooks and resets.
+     * If the FreeRTOS tick itself runs on the watchdog (portUSE_WDTO), the watchdog is only
+     * used to perform the reset.
+     * @param timeoutMs Allowed overrun before a task is declared hung.
+     */
+    void enableSupervisor(uint16_t timeoutMs);
+
+    /**
+     * @brief Computes per-task and idle CPU load since the previous call (or boot).
+     * With CPUSTATS (the "cpustats" env in platformio.ini) CPU time is charged at every
+     * context switch on the ProfilingClock time base, so loads exclude preemption and ISRs
+     * add up to 100% with idle and other tasks; grouped entries split their task's time by
+     * loopFunc time. The window must stay below 268 s (ProfilingClock wrap).
+     * Without CPUSTATS, task loads are wall-clock loopFunc time including preemption, so they
+     * can overlap, and idle is the remainder.
+     * Call from a single task only (it keeps the previous snapshot).
+     * @param load Receives the result.
+     */
+    void getCpuLoad(CpuLoad& load);
+
+    /**
+     * @brief Counts idle-hook calls for CpuLoad::idleHookCalls. Optional, call it from the
+     * Arduino loop(), which the FreeRTOS port runs from its idle hook.
+     */
+    void idleHook();
+
+    /**
+     * @brief Registers a hook that puts hardware into a safe state, e.g. Cover::safeStopAll.
+     * @return false if CONTROLLER_RUNNER_MAX_SAFE_STATE_HOOKS hooks are already registered.
+     */
+    bool addSafeStateHook(SafeStateHook hook);
+
+    /**
+     * @brief Runs all safe-state hooks and resets the controller through the watchdog. Never returns.
+     */
+    void enterSafeStateAndReset();
+
+    /**
+     * @brief Returns true if entry i runs in the task of an earlier entry of its group, so
+     * its stackSize and buffers are ignored.
+     */
+    template <size_t N>
+    constexpr bool isGroupFollower(const TaskConfig (&tasks)[N], size_t i)
+    {
+        if (tasks[i].group == 0)
+        {
+            return false;
+        }
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (tasks[j].group == tasks[i].group)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Returns the stack and TCB RAM (in bytes) taken by tasks with static buffers.
+     * Usable in a static_assert when the task table is declared constexpr.
+     * @param tasks The task table.
+     * @return Total bytes reserved statically for stacks and TCBs.
+     */
+    template <size_t N>
+    constexpr size_t staticRamBytes(const TaskConfig (&tasks)[N])
+    {
+        size_t total = 0;
+#if configSUPPORT_STATIC_ALLOCATION == 1
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (!isGroupFollower(tasks, i) && tasks[i].stackBuffer != nullptr && tasks[i].tcbBuffer != nullptr)
+            {
+                total += tasks[i].stackSize * sizeof(StackType_t) + sizeof(StaticTask_t);
+            }
+        }
+#endif
+        return total;
+    }
+
+    /**
+     * @brief Returns the stack RAM (in bytes) requested by all tasks, static and dynamic.
+     * Grouped entries count once, with the stack of their group's first entry.
+     * @param tasks The task table.
+     * @return Sum of stackSize over all created tasks, in bytes.
+     */
+    template <size_t N>
+    constexpr size_t totalStackBytes(const TaskConfig (&tasks)[N])
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (!isGroupFollower(tasks, i))
+            {
+                total += tasks[i].stackSize * sizeof(StackType_t);
+            }
+        }
+        return total;
+    }
 }
 
 #endif // AHA_DEVICES_CONTROLLER_RUNNER_H
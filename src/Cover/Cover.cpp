@@ -1,4 +1,12 @@
+#define DEBUG_MODULE LogModule::COVER
 #include "Cover.h"
+#include "BootProfiler.h"
+#include "Bus/MqttBusLock.h"
+#ifdef TRACEPOINTS_COVER
+#define TRACEPOINTS_ENABLED
+#endif
+#include "Trace/Tracepoint.h"
+#include "Trace/Trace.h"
 
 // Initialization of the static head pointer for our linked list.
 Cover* Cover::_head = nullptr;
@@ -126,6 +134,7 @@ void Cover::setup()
 {
     for (Cover* current = _head; current != nullptr; current = current->_nextInstance)
     {
+        BOOT_PROFILE_SCOPE(F("Cover"), current->_haCover->uniqueId());
         current->_setup();
     }
 }
@@ -162,6 +171,48 @@ void Cover::openAll()
     }
 }
 
+bool Cover::isAnyTargeting()
+{
+    for (Cover* current = _head; current != nullptr; current = current->_nextInstance)
+    {
+        if (current->isTargeting())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Cover::safeStopAll()
+{
+    for (Cover* current = _head; current != nullptr; current = current->_nextInstance)
+    {
+        digitalWrite(current->_motorUpPin, LOW);
+        digitalWrite(current->_motorDownPin, LOW);
+        current->_motorState = DirectionNone;
+        current->_targetPositionMs = current->_currentPositionMs;
+        current->_targetTiltPositionMs = current->_currentTiltPositionMs;
+        current->_state = StateIdle;
+    }
+
+    // Persist only after every relay is off, EEPROM writes are slow. Through the write-behind
+    // cache, so the positions are written once, together with any older pending value.
+    for (Cover* current = _head; current != nullptr; current = current->_nextInstance)
+    {
+        EepromService::writeBehind<long>(current->_eepromAddrPosition, current->_currentPositionMs);
+        if (current->_tiltEnabled)
+        {
+            EepromService::writeBehind<long>(current->_eepromAddrTilt, current->_currentTiltPositionMs);
+        }
+    }
+    EepromService::flush();
+}
+
+void Cover::onWakeRequest(void (*callback)())
+{
+    _wakeCallback = callback;
+}
+
 void Cover::openCover(Cover* cover, ButtonEvent event)
 {
     if (!cover) return;
@@ -324,6 +375,7 @@ void Cover::onCommand(HACover::CoverCommand command, HACover* sender)
     {
         return;
     }
+    TPRINT(COVER_COMMAND, sender->uniqueId(), (uint8_t)command);
 
     cover->_updateHAState();
 
@@ -382,6 +434,7 @@ void Cover::_loop()
 void Cover::_motorUp()
 {
     DPRINTLN(F("[Cover] #_motorUp()"));
+    TPRINT(COVER_MOTOR_UP, _haCover->uniqueId(), (int32_t)_currentPositionMs);
     digitalWrite(_motorUpPin, HIGH);
     digitalWrite(_motorDownPin, LOW);
     _motorState = DirectionUp;
@@ -390,6 +443,7 @@ void Cover::_motorUp()
 void Cover::_motorDown()
 {
     DPRINTLN(F("[Cover] #_motorDown()"));
+    TPRINT(COVER_MOTOR_DOWN, _haCover->uniqueId(), (int32_t)_currentPositionMs);
     digitalWrite(_motorUpPin, LOW);
     digitalWrite(_motorDownPin, HIGH);
     _motorState = DirectionDown;
@@ -398,6 +452,7 @@ void Cover::_motorDown()
 void Cover::_motorStop()
 {
     DPRINTLN(F("[Cover] #_motorStop()"));
+    TPRINT(COVER_MOTOR_STOP, _haCover->uniqueId(), (int32_t)_currentPositionMs);
     digitalWrite(_motorUpPin, LOW);
     digitalWrite(_motorDownPin, LOW);
     _motorState = DirectionNone;
@@ -410,6 +465,7 @@ void Cover::_stateIdle()
     if (_currentPositionMs != _targetPositionMs)
     {
         _state = StateTargetingPosition;
+        TRACE_EVENT(TP_COVER_STATE, _state);
         DPRINTLN(F("[Cover] #_stateIdle() -> StateTargetingPosition"));
         return;
     }
@@ -417,6 +473,7 @@ void Cover::_stateIdle()
     if (_currentTiltPositionMs != _targetTiltPositionMs)
     {
         _state = StateTargetingTilt;
+        TRACE_EVENT(TP_COVER_STATE, _state);
         DPRINTLN(F("[Cover] #_stateIdle() -> StateTargetingTilt"));
         return;
     }
@@ -424,6 +481,7 @@ void Cover::_stateIdle()
 
 void Cover::_stateTargetingPosition()
 {
+    TRACE_SCOPE(TP_COVER_TARGETING);
     if (_isSafetyDelayActive())
     {
         return;
@@ -441,14 +499,20 @@ void Cover::_stateTargetingPosition()
         {
             DPRINT(F("[Cover] #_stateTargeting() -> motorUp -> _currentPositionMs: "));
             DPRINTLN(_currentPositionMs);
-            _haCover->setState(HACover::CoverState::StateOpening, true);
+            {
+                MqttBusLock lock;
+                _haCover->setState(HACover::CoverState::StateOpening, true);
+            }
             _motorUp();
         }
         else if (_currentPositionMs < _targetPositionMs)
         {
             DPRINT(F("[Cover] #_stateTargeting() -> motorDown -> _currentPositionMs: "));
             DPRINTLN(_currentPositionMs);
-            _haCover->setState(HACover::CoverState::StateClosing, true);
+            {
+                MqttBusLock lock;
+                _haCover->setState(HACover::CoverState::StateClosing, true);
+            }
             _motorDown();
         }
         else if (_currentPositionMs == _targetPositionMs)
@@ -456,6 +520,7 @@ void Cover::_stateTargetingPosition()
             DPRINT(F("[Cover] #_stateTargeting() -> _state=StateIdle -> _currentPositionMs: "));
             DPRINTLN(_currentPositionMs);
             _state = _tiltEnabled ? StateTargetingTilt : StateIdle;
+            TRACE_EVENT(TP_COVER_STATE, _state);
         }
 
         _lastUpdatedAt = millis();
@@ -563,6 +628,7 @@ void Cover::_stateTargetingTilt()
         else if (_currentTiltPositionMs == _targetTiltPositionMs)
         {
             _state = StateIdle;
+            TRACE_EVENT(TP_COVER_STATE, _state);
             DPRINTLN(F("[Cover] #_stateTargetingTilt() -> _state=StateIdle"));
         }
 
@@ -645,6 +711,9 @@ void Cover::setTargetPosition(uint8_t position)
     DPRINT(position);
     DPRINT(F(", _fullCourseTimeMs: "));
     DPRINTLN(_fullCourseTimeMs);
+    TPRINT(COVER_TARGET, _haCover->uniqueId(), position, (int32_t)_targetPositionMs);
+
+    if (_wakeCallback) _wakeCallback();
 }
 
 void Cover::setTargetTiltPosition(uint8_t position)
@@ -654,6 +723,9 @@ void Cover::setTargetTiltPosition(uint8_t position)
     DPRINT(position);
     DPRINT(F(") -> _targetTiltPositionMs: "));
     DPRINTLN(_targetTiltPositionMs);
+    TPRINT(COVER_TARGET_TILT, _haCover->uniqueId(), position, (int32_t)_targetTiltPositionMs);
+
+    if (_wakeCallback) _wakeCallback();
 }
 
 void Cover::stop()
@@ -664,11 +736,14 @@ void Cover::stop()
     DPRINT(F("[Cover] #stop() -> _targetPositionMs: "));
     DPRINT(_targetPositionMs);
     DPRINTLN(F(" _motorStop()"));
+    TPRINT(COVER_STOP, _haCover->uniqueId(), (int32_t)_currentPositionMs);
     _state = Cover::StateIdle;
-    EepromService::write<long>(_eepromAddrPosition, _currentPositionMs);
+    TRACE_EVENT(TP_COVER_STATE, _state);
+    // Deferred, a burst of commands ends in a single write per block.
+    EepromService::writeBehind<long>(_eepromAddrPosition, _currentPositionMs);
     if (_tiltEnabled)
     {
-        EepromService::write<long>(_eepromAddrTilt, _currentTiltPositionMs);
+        EepromService::writeBehind<long>(_eepromAddrTilt, _currentTiltPositionMs);
     }
 }
 
@@ -707,6 +782,7 @@ bool Cover::isTargeting() const
 
 void Cover::_updateHAState() const
 {
+    MqttBusLock lock;
     if (_currentTiltPositionMs == _targetTiltPositionMs && _currentPositionMs == _targetPositionMs)
     {
         _haCover->setPosition(getCurrentPosition(), true);
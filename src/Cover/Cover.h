@@ -22,9 +22,22 @@ public:
     static void publishAllStates();
     static void closeAll();
     static void openAll();
+    static bool isAnyTargeting();
+
+    /**
+     * @brief Emergency stop for all covers: relays off and positions persisted, without any
+     * HA/MQTT traffic. Intended as a ControllerRunner safe-state hook.
+     */
+    static void safeStopAll();
     static void openCover(Cover* cover, ButtonEvent event);
     static void closeCover(Cover* cover, ButtonEvent event);
 
+    /**
+     * @brief Registers a callback invoked whenever a new target is set on any cover,
+     * so the task running loop() can be woken (e.g. ControllerRunner::notify) instead of polling.
+     */
+    static void onWakeRequest(void (*callback)());
+
     // --- Public constants ---
     inline static int calibrationTimeMs = 1000;
 
@@ -134,6 +147,7 @@ private:
     // --- Linked List for Instance Management ---
     Cover* _nextInstance;
     static Cover* _head;
+    inline static void (*_wakeCallback)() = nullptr;
 
     // --- Private static callback handling (no prefix) ---
     static Cover* findInstance(HACover* haCover);
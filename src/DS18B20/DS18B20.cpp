@@ -1,4 +1,10 @@
+#define DEBUG_MODULE LogModule::DS18B20
 #include "DS18B20.h"
+#include "BootProfiler.h"
+#ifdef TRACEPOINTS_DS18B20
+#define TRACEPOINTS_ENABLED
+#endif
+#include "Trace/Tracepoint.h"
 
 #include "Debug.h"
 
@@ -28,6 +34,7 @@ void DS18B20::begin()
         return;
     }
 
+    BOOT_PROFILE_SCOPE(F("DS18B20"), nullptr);
     _dallas.begin();
     // Non-blocking conversion mode
     _dallas.setWaitForConversion(false);
@@ -53,6 +60,7 @@ void DS18B20::begin()
 
     _beginCalled = true;
     _state = State::Idle;
+    TRACE_EVENT(TP_DS18B20_STATE, _state);
     _lastMeasurementTime = 0;
     DPRINTLN(F("[DS18B20] Initialized."));
 }
@@ -75,12 +83,14 @@ void DS18B20::loop()
             _requestAll();
             _lastRequestTime = now;
             _state = State::Requesting;
+            TRACE_EVENT(TP_DS18B20_STATE, _state);
         }
         break;
 
     case State::Requesting:
         // Immediately after request, we go to WAITING
         _state = State::Waiting;
+        TRACE_EVENT(TP_DS18B20_STATE, _state);
         break;
 
     case State::Waiting:
@@ -88,6 +98,7 @@ void DS18B20::loop()
         if ((now - _lastRequestTime) >= CONVERSION_TIME_MS)
         {
             _state = State::Reading;
+            TRACE_EVENT(TP_DS18B20_STATE, _state);
         }
         break;
 
@@ -98,6 +109,7 @@ void DS18B20::loop()
         _lastMeasurementTime = now;
         // Move back to Idle
         _state = State::Idle;
+        TRACE_EVENT(TP_DS18B20_STATE, _state);
         break;
     }
 }
@@ -118,6 +130,7 @@ void DS18B20::_requestAll()
 
 void DS18B20::_readAll()
 {
+    TRACE_SCOPE(TP_DS18B20_READ);
     for (uint8_t i = 0; i < _sensorCount; i++)
     {
         float tempC = _dallas.getTempC((uint8_t*)_deviceAddrs[i]);
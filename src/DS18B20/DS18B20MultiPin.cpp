@@ -1,4 +1,11 @@
+#define DEBUG_MODULE LogModule::DS18B20
 #include "DS18B20MultiPin.h"
+#include "BootProfiler.h"
+#ifdef TRACEPOINTS_DS18B20
+#define TRACEPOINTS_ENABLED
+#endif
+#include "Trace/Tracepoint.h"
+#include "Trace/Trace.h"
 #include "Debug.h"
 
 DS18B20MultiPin::DS18B20MultiPin(const uint8_t* pins, uint8_t sensorsCount)
@@ -68,6 +75,8 @@ void DS18B20MultiPin::begin()
 
     for (uint8_t i = 0; i < _sensorsCount; i++)
     {
+        BOOT_PROFILE_SCOPE(F("DS18B20 bus"), nullptr, _pins[i]);
+
         // 1. Przełącz magistralę
         _dallas->setOneWire(_oneWires[i]);
 
@@ -82,12 +91,14 @@ void DS18B20MultiPin::begin()
         }
         else
         {
-            DPRINTLN(F("[DS18B20MultiPin] WARNING: Sensor NOT found on startup!"));
+            WPRINTLN(F("[DS18B20MultiPin] WARNING: Sensor NOT found on startup!"));
+            TPRINT(DS18B20_NOT_FOUND, i);
         }
     }
 
     _beginCalled = true;
     _state = State::Idle;
+    TRACE_EVENT(TP_DS18B20_STATE, _state);
     _lastMeasurementTime = 0;
     DPRINTLN(F("[DS18B20MultiPin] Manager initialized."));
 }
@@ -110,17 +121,20 @@ void DS18B20MultiPin::loop()
             _requestAll();
             _lastRequestTime = now;
             _state = State::Requesting;
+            TRACE_EVENT(TP_DS18B20_STATE, _state);
         }
         break;
 
     case State::Requesting:
         _state = State::Waiting;
+        TRACE_EVENT(TP_DS18B20_STATE, _state);
         break;
 
     case State::Waiting:
         if ((now - _lastRequestTime) >= CONVERSION_TIME_MS)
         {
             _state = State::Reading;
+            TRACE_EVENT(TP_DS18B20_STATE, _state);
         }
         break;
 
@@ -128,6 +142,7 @@ void DS18B20MultiPin::loop()
         _readAll();
         _lastMeasurementTime = now;
         _state = State::Idle;
+        TRACE_EVENT(TP_DS18B20_STATE, _state);
         break;
     }
 }
@@ -160,8 +175,9 @@ void DS18B20MultiPin::_searchForMissingSensors()
 
             if (_dallas->getAddress(_addresses[i], 0))
             {
-                DPRINT(F("[DS18B20MultiPin] HOT-SWAP: Sensor FOUND on pin "));
-                DPRINTLN(i);
+                IPRINT(F("[DS18B20MultiPin] HOT-SWAP: Sensor FOUND on pin "));
+                IPRINTLN(i);
+                TPRINT(DS18B20_HOT_SWAP, i);
                 _dallas->setResolution(_addresses[i], 12);
 
                 // Reset filtrów dla nowego czujnika
@@ -188,6 +204,7 @@ void DS18B20MultiPin::_requestAll()
 
 void DS18B20MultiPin::_readAll()
 {
+    TRACE_SCOPE(TP_DS18B20_READ);
     DPRINTLN(F("[DS18B20MultiPin] Reading temperatures..."));
 
     for (uint8_t i = 0; i < _sensorsCount; i++)
@@ -205,14 +222,16 @@ void DS18B20MultiPin::_readAll()
         if (tempC == DEVICE_DISCONNECTED_C)
         {
             _consecutiveErrors[i]++;
-            DPRINT(F("[DS18B20MultiPin] Read Error pin "));
-            DPRINT(i);
-            DPRINT(F(" Count: "));
-            DPRINTLN(_consecutiveErrors[i]);
+            WPRINT(F("[DS18B20MultiPin] Read Error pin "));
+            WPRINT(i);
+            WPRINT(F(" Count: "));
+            WPRINTLN(_consecutiveErrors[i]);
+            TPRINT(DS18B20_READ_ERROR, i, _consecutiveErrors[i]);
 
             if (_consecutiveErrors[i] >= MAX_ERRORS)
             {
-                DPRINTLN(F(" -> SENSOR DISCONNECTED (Marked invalid)"));
+                WPRINTLN(F(" -> SENSOR DISCONNECTED (Marked invalid)"));
+                TPRINT(DS18B20_DISCONNECTED, i);
                 // Zerujemy adres -> w kolejnym Idle uruchomi się _searchForMissingSensors
                 memset(_addresses[i], 0, 8);
                 _tempSum[i] = -100.0f; // Reset stanu filtra
@@ -227,6 +246,7 @@ void DS18B20MultiPin::_readAll()
         if (tempC < -15.0f || tempC > 45.0f)
         {
             DPRINTLN(F("[DS18B20MultiPin] Ignored outlier value."));
+            TPRINT(DS18B20_OUTLIER, tempC, i);
             continue;
         }
 
@@ -264,6 +284,7 @@ void DS18B20MultiPin::_readAll()
             DPRINT(i);
             DPRINT(F(" avg: "));
             DPRINTLN(_lastTemperatures[i]);
+            TPRINT(DS18B20_UPDATED, i, _lastTemperatures[i]);
         }
     }
 }
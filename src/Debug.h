@@ -3,10 +3,172 @@
 
 // #define DEBUG
 // #define DEBUGSTACK
+// #define BOOTPROFILE
+// #define TRACE
+// #define TASKDIAGNOSTICS
+// #define LATENCYTRACE
+// #define PROFILINGCLOCK
+// #define DEBUGSERIAL
+// CPUSTATS (per-task CPU time at context switches) also needs the FreeRTOS switch hook,
+// use the "cpustats" env in platformio.ini instead of defining it here.
 
+// Baud rate of the diagnostic output (logs, DeferredLog, Trace).
+#ifndef DEBUG_SERIAL_BAUD
+#define DEBUG_SERIAL_BAUD 115200
+#endif
+
+// Port of the diagnostic output. DEBUGSERIAL replaces Serial by DebugSerial, which never blocks
+// the caller: bytes that do not fit into its ring are dropped and counted.
+#ifdef DEBUGSERIAL
+#include "DebugSerial.h"
+#define LOG_SERIAL DebugSerial
+#else
+#define LOG_SERIAL Serial
+#endif
+
+// Tracepoints (Trace/Tracepoint.h), enabled per module.
+// #define TRACEPOINTS_COVER
+// #define TRACEPOINTS_MOTOR
+// #define TRACEPOINTS_LEDSTRIP
+// #define TRACEPOINTS_DS18B20
+// #define TRACEPOINTS_BUTTON
+
+#if defined(TRACEPOINTS_COVER) || defined(TRACEPOINTS_MOTOR) || defined(TRACEPOINTS_LEDSTRIP) || \
+    defined(TRACEPOINTS_DS18B20) || defined(TRACEPOINTS_BUTTON)
+#define TRACEPOINTS
+#endif
+
+// TaskMonitor backs both the DEBUGSTACK reports and the TaskDiagnostics HA sensors.
+#if defined(DEBUGSTACK) || defined(TASKDIAGNOSTICS)
+#define TASKMONITOR
+#endif
+
+// --- Logging ---
+// Levels of the print macros: EPRINT (error), WPRINT (warn), IPRINT (info), DPRINT (debug).
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Compile-time threshold: messages above it are removed from the build. DEBUG enables all.
+// #define LOG_LEVEL LOG_LEVEL_WARN
+
+#ifndef LOG_LEVEL
 #ifdef DEBUG
-#define DPRINT(...) Serial.print(__VA_ARGS__)
-#define DPRINTLN(...) Serial.println(__VA_ARGS__)
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_LEVEL LOG_LEVEL_NONE
+#endif
+#endif
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+#define LOGGING
+
+#include <Arduino.h>
+
+/**
+ * @brief Module tag of a log message. A .cpp file selects its module by defining
+ * DEBUG_MODULE before its first include, e.g.:
+ *   #define DEBUG_MODULE LogModule::COVER
+ *   #include "Cover.h"
+ */
+enum class LogModule : uint8_t
+{
+    GENERAL,
+    RUNNER,
+    BUS,
+    COVER,
+    MOTOR,
+    LEDSTRIP,
+    LIGHT,
+    POWERSOCKET,
+    DS18B20,
+    MOTIONSENSOR,
+    DIAGNOSTICS,
+    COUNT
+};
+
+// Runtime level of every LogModule, starts at LOG_LEVEL.
+inline uint8_t g_logLevels[] = {
+    LOG_LEVEL, LOG_LEVEL, LOG_LEVEL, LOG_LEVEL, LOG_LEVEL, LOG_LEVEL,
+    LOG_LEVEL, LOG_LEVEL, LOG_LEVEL, LOG_LEVEL, LOG_LEVEL
+};
+static_assert(sizeof(g_logLevels) == (size_t)LogModule::COUNT, "One entry of g_logLevels per LogModule");
+
+/**
+ * @brief Runtime filtering of the messages that passed LOG_LEVEL, e.g. to debug a single
+ * subsystem while the others stay quiet:
+ *   Log::setLevel(LOG_LEVEL_WARN);
+ *   Log::setLevel(LogModule::COVER, LOG_LEVEL_DEBUG);
+ */
+namespace Log
+{
+    inline void setLevel(LogModule module, uint8_t level)
+    {
+        g_logLevels[(uint8_t)module] = level;
+    }
+
+    /**
+     * @brief Sets the level of all modules.
+     */
+    inline void setLevel(uint8_t level)
+    {
+        for (uint8_t& moduleLevel : g_logLevels)
+        {
+            moduleLevel = level;
+        }
+    }
+
+    inline uint8_t getLevel(LogModule module)
+    {
+        return g_logLevels[(uint8_t)module];
+    }
+
+    inline bool isEnabled(LogModule module, uint8_t level)
+    {
+        return level <= g_logLevels[(uint8_t)module];
+    }
+}
+
+#ifndef DEBUG_MODULE
+#define DEBUG_MODULE LogModule::GENERAL
+#endif
+
+#define LOG_PRINT(level, method, ...) \
+    do \
+    { \
+        if (Log::isEnabled(DEBUG_MODULE, level)) LOG_SERIAL.method(__VA_ARGS__); \
+    } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define EPRINT(...) LOG_PRINT(LOG_LEVEL_ERROR, print, __VA_ARGS__)
+#define EPRINTLN(...) LOG_PRINT(LOG_LEVEL_ERROR, println, __VA_ARGS__)
+#else
+#define EPRINT(...)
+#define EPRINTLN(...)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define WPRINT(...) LOG_PRINT(LOG_LEVEL_WARN, print, __VA_ARGS__)
+#define WPRINTLN(...) LOG_PRINT(LOG_LEVEL_WARN, println, __VA_ARGS__)
+#else
+#define WPRINT(...)
+#define WPRINTLN(...)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define IPRINT(...) LOG_PRINT(LOG_LEVEL_INFO, print, __VA_ARGS__)
+#define IPRINTLN(...) LOG_PRINT(LOG_LEVEL_INFO, println, __VA_ARGS__)
+#else
+#define IPRINT(...)
+#define IPRINTLN(...)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define DPRINT(...) LOG_PRINT(LOG_LEVEL_DEBUG, print, __VA_ARGS__)
+#define DPRINTLN(...) LOG_PRINT(LOG_LEVEL_DEBUG, println, __VA_ARGS__)
 #else
 #define DPRINT(...)
 #define DPRINTLN(...)
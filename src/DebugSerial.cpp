@@ -0,0 +1,151 @@
+#include "DebugSerial.h"
+
+#ifdef DEBUGSERIAL
+
+static_assert((DEBUG_SERIAL_TX_BUFFER_SIZE & (DEBUG_SERIAL_TX_BUFFER_SIZE - 1)) == 0,
+              "DEBUG_SERIAL_TX_BUFFER_SIZE must be a power of two");
+
+static const uint16_t INDEX_MASK = DEBUG_SERIAL_TX_BUFFER_SIZE - 1;
+
+DebugSerialClass DebugSerial;
+
+ISR(USART0_UDRE_vect)
+{
+    DebugSerial._transmitNext();
+}
+
+void DebugSerialClass::begin(unsigned long baud)
+{
+    // Double speed mode, same divisor rounding as HardwareSerial.
+    uint16_t divisor = (F_CPU / 4 / baud - 1) / 2;
+
+    uint8_t sreg = SREG;
+    cli();
+    UCSR0A = _BV(U2X0);
+    UBRR0H = divisor >> 8;
+    UBRR0L = divisor;
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00); // 8 data bits, no parity, 1 stop bit.
+    UCSR0B = _BV(TXEN0);
+    _head = _tail = 0;
+    SREG = sreg;
+}
+
+size_t DebugSerialClass::write(uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t DebugSerialClass::write(const uint8_t* buffer, size_t size)
+{
+    _reportDropped();
+
+    uint8_t sreg = SREG;
+    cli();
+    size_t queued = _queue(buffer, size);
+    _droppedBytes += size - queued;
+    SREG = sreg;
+
+    return queued;
+}
+
+size_t DebugSerialClass::_queue(const uint8_t* buffer, size_t size)
+{
+    uint16_t head = _head;
+    uint16_t space = INDEX_MASK - ((head - _tail) & INDEX_MASK);
+    size_t queued = size < space ? size : space;
+    for (size_t i = 0; i < queued; ++i)
+    {
+        _buffer[head] = buffer[i];
+        head = (head + 1) & INDEX_MASK;
+    }
+    _head = head;
+    if (queued > 0)
+    {
+        UCSR0B |= _BV(UDRIE0);
+    }
+    return queued;
+}
+
+void DebugSerialClass::_reportDropped()
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t reported = _reportedDroppedBytes;
+    uint32_t dropped = _droppedBytes - reported;
+    SREG = sreg;
+    if (dropped == 0)
+    {
+        return;
+    }
+
+    // Starts on a new line, the drop may have cut the previous one.
+    char line[40];
+    strcpy_P(line, PSTR("\r\n[serial] dropped "));
+    ultoa(dropped, line + strlen(line), 10);
+    strcat_P(line, PSTR(" bytes\r\n"));
+    size_t length = strlen(line);
+
+    cli();
+    // Only whole lines, and only once if another writer got here first.
+    if (_reportedDroppedBytes == reported && availableForWrite() >= (int)length)
+    {
+        _queue(reinterpret_cast<const uint8_t*>(line), length);
+        _reportedDroppedBytes = reported + dropped;
+    }
+    SREG = sreg;
+}
+
+int DebugSerialClass::availableForWrite()
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t space = INDEX_MASK - ((_head - _tail) & INDEX_MASK);
+    SREG = sreg;
+    return space;
+}
+
+void DebugSerialClass::flush()
+{
+    while (_head != _tail)
+    {
+        // With interrupts disabled (e.g. on the way to a reset) the interrupt cannot run, so poll.
+        if (!(SREG & _BV(SREG_I)) && (UCSR0A & _BV(UDRE0)))
+        {
+            _transmitNext();
+        }
+    }
+
+    if (_written)
+    {
+        while (!(UCSR0A & _BV(TXC0)))
+        {
+        }
+    }
+}
+
+uint32_t DebugSerialClass::droppedBytes() const
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t dropped = _droppedBytes;
+    SREG = sreg;
+    return dropped;
+}
+
+void DebugSerialClass::_transmitNext()
+{
+    uint16_t tail = _tail;
+    if (_head == tail)
+    {
+        UCSR0B &= ~_BV(UDRIE0);
+        return;
+    }
+
+    // Clear TXC0 (by writing one) together with the byte, keeping U2X0.
+    UCSR0A = (UCSR0A & _BV(U2X0)) | _BV(TXC0);
+    UDR0 = _buffer[tail];
+    _tail = (tail + 1) & INDEX_MASK;
+    _written = true;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef AHA_DEVICES_DEBUG_SERIAL_H
+#define AHA_DEVICES_DEBUG_SERIAL_H
+
+#include <Arduino.h>
+#include "Debug.h"
+
+#ifdef DEBUGSERIAL
+
+// Transmit ring size in bytes, must be a power of two.
+#ifndef DEBUG_SERIAL_TX_BUFFER_SIZE
+#define DEBUG_SERIAL_TX_BUFFER_SIZE 512
+#endif
+
+/**
+ * @class DebugSerialClass
+ * @brief Transmit-only driver of USART0 for diagnostic output, enabled with DEBUGSERIAL in Debug.h.
+ * write() copies into a RAM ring and returns at once; the USART data-register-empty interrupt
+ * sends the bytes. When the ring is full the rest of the write is dropped and counted, so a
+ * logging task (or an HA callback) never waits for the UART. The next write() that finds room
+ * first queues a "[serial] dropped N bytes" line, so every DEBUGSERIAL build shows the losses.
+ * It owns USART0 and its interrupt: do not use Serial in a DEBUGSERIAL build, everything in
+ * this repository prints through LOG_SERIAL from Debug.h instead.
+ */
+class DebugSerialClass : public Print
+{
+public:
+    /**
+     * @brief Configures USART0 for 8N1 at the given baud rate. ControllerRunner::run() calls it.
+     */
+    void begin(unsigned long baud);
+
+    size_t write(uint8_t byte) override;
+
+    /**
+     * @brief Queues as much of the buffer as fits and returns the number of bytes queued.
+     */
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    using Print::write;
+
+    /**
+     * @brief Returns the free space of the ring in bytes.
+     */
+    int availableForWrite() override;
+
+    /**
+     * @brief Waits until everything queued is sent. Blocking, for the reset path only;
+     * also works with interrupts disabled.
+     */
+    void flush() override;
+
+    /**
+     * @brief Returns the number of bytes dropped because the ring was full, since boot.
+     */
+    uint32_t droppedBytes() const;
+
+    // Called by the USART0 interrupt, not part of the API.
+    void _transmitNext();
+
+private:
+    /**
+     * @brief Copies as much of the buffer as fits into the ring. Interrupts must be disabled.
+     */
+    size_t _queue(const uint8_t* buffer, size_t size);
+
+    /**
+     * @brief Queues a line with the bytes dropped since the last one, if it fits.
+     */
+    void _reportDropped();
+
+    uint8_t _buffer[DEBUG_SERIAL_TX_BUFFER_SIZE];
+    volatile uint16_t _head = 0; // Next byte to queue.
+    volatile uint16_t _tail = 0; // Next byte to send.
+    volatile uint32_t _droppedBytes = 0;
+    uint32_t _reportedDroppedBytes = 0; // Part of _droppedBytes already reported in-band.
+    volatile bool _written = false; // A byte was sent, TXC0 tells when it left the shift register.
+};
+
+extern DebugSerialClass DebugSerial;
+
+#endif
+
+#endif // AHA_DEVICES_DEBUG_SERIAL_H
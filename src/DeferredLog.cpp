@@ -0,0 +1,318 @@
+#include "DeferredLog.h"
+
+#ifdef DEBUGSTACK
+
+static_assert((DEFERRED_LOG_RING_SIZE & (DEFERRED_LOG_RING_SIZE - 1)) == 0 && DEFERRED_LOG_RING_SIZE <= 128,
+              "DEFERRED_LOG_RING_SIZE must be a power of two, at most 128");
+
+// With DEBUGSERIAL, free ring bytes needed before a record is written (longest string printed).
+static const int DEFERRED_LOG_TX_RESERVE = 96;
+#ifdef DEBUGSERIAL
+static_assert(DEBUG_SERIAL_TX_BUFFER_SIZE > DEFERRED_LOG_TX_RESERVE, "DEBUG_SERIAL_TX_BUFFER_SIZE is too small for DeferredLog");
+#endif
+
+// How often the drain task empties the rings.
+static const TickType_t DRAIN_PERIOD_TICKS = pdMS_TO_TICKS(100) > 0 ? pdMS_TO_TICKS(100) : 1;
+
+enum RecordType : uint8_t
+{
+    RECORD_FLASH,
+    RECORD_STRING,
+    RECORD_CHAR,
+    RECORD_SIGNED,
+    RECORD_UNSIGNED,
+    RECORD_FLOAT,
+    RECORD_EMPTY
+};
+
+// Set in Record::type when a newline follows the value.
+static const uint8_t RECORD_NEWLINE = 0x80;
+
+/**
+ * @struct Record
+ * @brief One unformatted print() call.
+ */
+struct Record
+{
+    uint8_t type; // RecordType, optionally with RECORD_NEWLINE.
+    uint8_t format; // Base for integers, digits for floats.
+    union
+    {
+        const __FlashStringHelper* flash;
+        const char* string;
+        char c;
+        long s;
+        unsigned long u;
+        float f;
+    } value;
+};
+
+/**
+ * @struct Ring
+ * @brief Single-producer/single-consumer ring owned by one task.
+ * Only the owner writes head and dropped, only the drain task writes tail; the indices are
+ * single bytes, so they are read and written atomically on AVR.
+ */
+struct Ring
+{
+    TaskHandle_t owner;
+    Record records[DEFERRED_LOG_RING_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t dropped;
+    uint16_t reportedDropped; // Drain task only.
+};
+
+static Ring s_rings[DEFERRED_LOG_MAX_PRODUCERS];
+static volatile uint16_t s_unownedDropped = 0; // Records of tasks that found no free ring.
+static uint16_t s_reportedUnownedDropped = 0;
+
+// Keeps the compiler from moving the record stores past the index update.
+#define DEFERRED_LOG_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * @brief Prints a record directly to LOG_SERIAL.
+ */
+static void write_record(const Record& record)
+{
+    switch (record.type & ~RECORD_NEWLINE)
+    {
+    case RECORD_FLASH:
+        LOG_SERIAL.print(record.value.flash);
+        break;
+    case RECORD_STRING:
+        LOG_SERIAL.print(record.value.string);
+        break;
+    case RECORD_CHAR:
+        LOG_SERIAL.print(record.value.c);
+        break;
+    case RECORD_SIGNED:
+        LOG_SERIAL.print(record.value.s, record.format);
+        break;
+    case RECORD_UNSIGNED:
+        LOG_SERIAL.print(record.value.u, record.format);
+        break;
+    case RECORD_FLOAT:
+        LOG_SERIAL.print(record.value.f, record.format);
+        break;
+    default:
+        break;
+    }
+
+    if (record.type & RECORD_NEWLINE)
+    {
+        LOG_SERIAL.println();
+    }
+}
+
+/**
+ * @brief Returns the ring of the calling task, claiming a free one on first use.
+ */
+static Ring* ring_of_current_task()
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (Ring& ring : s_rings)
+    {
+        if (ring.owner == self)
+        {
+            return &ring;
+        }
+    }
+
+    Ring* claimed = nullptr;
+    taskENTER_CRITICAL();
+    for (Ring& ring : s_rings)
+    {
+        if (ring.owner == NULL)
+        {
+            ring.owner = self;
+            claimed = &ring;
+            break;
+        }
+    }
+    if (claimed == nullptr)
+    {
+        s_unownedDropped++;
+    }
+    taskEXIT_CRITICAL();
+    return claimed;
+}
+
+/**
+ * @brief Enqueues a record for the calling task, never blocks.
+ */
+static void push(const Record& record)
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        // Single-threaded setup(): nothing to protect and nobody to drain.
+        write_record(record);
+        return;
+    }
+
+    Ring* ring = ring_of_current_task();
+    if (ring == nullptr)
+    {
+        return;
+    }
+
+    uint8_t head = ring->head;
+    if ((uint8_t)(head - ring->tail) >= DEFERRED_LOG_RING_SIZE)
+    {
+        ring->dropped++;
+        return;
+    }
+
+    ring->records[head & (DEFERRED_LOG_RING_SIZE - 1)] = record;
+    DEFERRED_LOG_BARRIER();
+    ring->head = head + 1;
+}
+
+/**
+ * @brief Writes the complete lines queued in a ring. A full ring without a newline is
+ * written anyway, otherwise it could never make room again.
+ */
+static void drain_ring(Ring& ring)
+{
+    uint8_t tail = ring.tail;
+    uint8_t head = ring.head;
+    DEFERRED_LOG_BARRIER();
+
+    uint8_t end = tail;
+    for (uint8_t i = tail; i != head; ++i)
+    {
+        if (ring.records[i & (DEFERRED_LOG_RING_SIZE - 1)].type & RECORD_NEWLINE)
+        {
+            end = i + 1;
+        }
+    }
+    if (end == tail && (uint8_t)(head - tail) >= DEFERRED_LOG_RING_SIZE)
+    {
+        end = head;
+    }
+
+    for (; tail != end; ++tail)
+    {
+#ifdef DEBUGSERIAL
+        while (LOG_SERIAL.availableForWrite() < DEFERRED_LOG_TX_RESERVE)
+        {
+            vTaskDelay(1);
+        }
+#endif
+        write_record(ring.records[tail & (DEFERRED_LOG_RING_SIZE - 1)]);
+    }
+    DEFERRED_LOG_BARRIER();
+    ring.tail = tail;
+
+    taskENTER_CRITICAL();
+    uint16_t dropped = ring.dropped;
+    taskEXIT_CRITICAL();
+    if (dropped != ring.reportedDropped)
+    {
+        LOG_SERIAL.print(F("[log] dropped "));
+        LOG_SERIAL.print((uint16_t)(dropped - ring.reportedDropped));
+        LOG_SERIAL.print(F(" records of "));
+        LOG_SERIAL.println(pcTaskGetName(ring.owner));
+        ring.reportedDropped = dropped;
+    }
+}
+
+/**
+ * @brief Drain task: periodically writes everything queued to LOG_SERIAL.
+ * Serial.print may block here while the TX buffer is full, which only delays this task;
+ * with DEBUGSERIAL the task waits for ring space instead, so its output is not dropped.
+ */
+static void drain_task(void*)
+{
+    for (;;)
+    {
+        vTaskDelay(DRAIN_PERIOD_TICKS);
+
+        for (Ring& ring : s_rings)
+        {
+            if (ring.owner != NULL)
+            {
+                drain_ring(ring);
+            }
+        }
+
+        taskENTER_CRITICAL();
+        uint16_t unownedDropped = s_unownedDropped;
+        taskEXIT_CRITICAL();
+        if (unownedDropped != s_reportedUnownedDropped)
+        {
+            LOG_SERIAL.print(F("[log] dropped "));
+            LOG_SERIAL.print((uint16_t)(unownedDropped - s_reportedUnownedDropped));
+            LOG_SERIAL.println(F(" records, increase DEFERRED_LOG_MAX_PRODUCERS"));
+            s_reportedUnownedDropped = unownedDropped;
+        }
+    }
+}
+
+bool DeferredLog::begin(UBaseType_t priority, uint16_t stackSize)
+{
+    return xTaskCreate(drain_task, "LOG", stackSize, NULL, priority, NULL) == pdPASS;
+}
+
+uint32_t DeferredLog::droppedCount()
+{
+    uint32_t total;
+    taskENTER_CRITICAL();
+    total = s_unownedDropped;
+    for (const Ring& ring : s_rings)
+    {
+        total += ring.dropped;
+    }
+    taskEXIT_CRITICAL();
+    return total;
+}
+
+void DeferredLog::print(const __FlashStringHelper* text, bool newline)
+{
+    Record record{(uint8_t)(RECORD_FLASH | (newline ? RECORD_NEWLINE : 0)), 0, {}};
+    record.value.flash = text;
+    push(record);
+}
+
+void DeferredLog::print(const char* text, bool newline)
+{
+    Record record{(uint8_t)(RECORD_STRING | (newline ? RECORD_NEWLINE : 0)), 0, {}};
+    record.value.string = text;
+    push(record);
+}
+
+void DeferredLog::print(char c, bool newline)
+{
+    Record record{(uint8_t)(RECORD_CHAR | (newline ? RECORD_NEWLINE : 0)), 0, {}};
+    record.value.c = c;
+    push(record);
+}
+
+void DeferredLog::printSigned(long value, uint8_t base, bool newline)
+{
+    Record record{(uint8_t)(RECORD_SIGNED | (newline ? RECORD_NEWLINE : 0)), base, {}};
+    record.value.s = value;
+    push(record);
+}
+
+void DeferredLog::printUnsigned(unsigned long value, uint8_t base, bool newline)
+{
+    Record record{(uint8_t)(RECORD_UNSIGNED | (newline ? RECORD_NEWLINE : 0)), base, {}};
+    record.value.u = value;
+    push(record);
+}
+
+void DeferredLog::printFloat(double value, uint8_t digits, bool newline)
+{
+    Record record{(uint8_t)(RECORD_FLOAT | (newline ? RECORD_NEWLINE : 0)), digits, {}};
+    record.value.f = value;
+    push(record);
+}
+
+void DeferredLog::println()
+{
+    Record record{(uint8_t)(RECORD_EMPTY | RECORD_NEWLINE), 0, {}};
+    push(record);
+}
+
+#endif
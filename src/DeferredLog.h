@@ -0,0 +1,75 @@
+#ifndef AHA_DEVICES_DEFERRED_LOG_H
+#define AHA_DEVICES_DEFERRED_LOG_H
+
+#include "Debug.h"
+
+#ifdef DEBUGSTACK
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+
+// Number of tasks that can log at the same time; each one gets its own ring buffer.
+#ifndef DEFERRED_LOG_MAX_PRODUCERS
+#define DEFERRED_LOG_MAX_PRODUCERS 4
+#endif
+
+// Records per ring buffer, must be a power of two (at most 128). One record is 6 bytes,
+// a TaskMonitor report takes about 25.
+#ifndef DEFERRED_LOG_RING_SIZE
+#define DEFERRED_LOG_RING_SIZE 32
+#endif
+
+/**
+ * @brief Deferred logger behind SDPRINT/SDPRINTLN.
+ * Each task enqueues compact records into its own single-producer ring buffer without
+ * blocking or locking; a low-priority drain task formats them and writes them to LOG_SERIAL,
+ * whole lines at a time. Records that do not fit are counted and reported as dropped.
+ * Values are stored, not formatted: strings are kept by pointer, so only pass F() strings
+ * or SRAM strings that stay valid (e.g. task names). Not for use from an ISR.
+ * Before the scheduler starts, everything is printed directly.
+ */
+namespace DeferredLog
+{
+    /**
+     * @brief Creates the drain task. ControllerRunner::run() calls it in DEBUGSTACK builds.
+     * @param priority Priority of the drain task, keep it below every time-critical task.
+     * @param stackSize Stack size of the drain task.
+     * @return false if the task could not be created.
+     */
+    bool begin(UBaseType_t priority = tskIDLE_PRIORITY, uint16_t stackSize = 192);
+
+    /**
+     * @brief Returns the number of records dropped since boot because a ring was full
+     * or all rings were taken by other tasks.
+     */
+    uint32_t droppedCount();
+
+    void print(const __FlashStringHelper* text, bool newline = false);
+    void print(const char* text, bool newline = false);
+    void print(char c, bool newline = false);
+    void printSigned(long value, uint8_t base, bool newline);
+    void printUnsigned(unsigned long value, uint8_t base, bool newline);
+    void printFloat(double value, uint8_t digits, bool newline);
+    void println();
+
+    inline void print(unsigned char value, int base = DEC) { printUnsigned(value, base, false); }
+    inline void print(int value, int base = DEC) { printSigned(value, base, false); }
+    inline void print(unsigned int value, int base = DEC) { printUnsigned(value, base, false); }
+    inline void print(long value, int base = DEC) { printSigned(value, base, false); }
+    inline void print(unsigned long value, int base = DEC) { printUnsigned(value, base, false); }
+    inline void print(double value, int digits = 2) { printFloat(value, digits, false); }
+
+    inline void println(const __FlashStringHelper* text) { print(text, true); }
+    inline void println(const char* text) { print(text, true); }
+    inline void println(char c) { print(c, true); }
+    inline void println(unsigned char value, int base = DEC) { printUnsigned(value, base, true); }
+    inline void println(int value, int base = DEC) { printSigned(value, base, true); }
+    inline void println(unsigned int value, int base = DEC) { printUnsigned(value, base, true); }
+    inline void println(long value, int base = DEC) { printSigned(value, base, true); }
+    inline void println(unsigned long value, int base = DEC) { printUnsigned(value, base, true); }
+    inline void println(double value, int digits = 2) { printFloat(value, digits, true); }
+}
+
+#endif
+
+#endif // AHA_DEVICES_DEFERRED_LOG_H
@@ -3,11 +3,44 @@
 
 #include <Arduino.h>
 #include <EEPROM.h>
+#include <util/atomic.h>
+#include "EepromWriter.h"
+
+// Number of blocks whose latest slot is kept in RAM, 0 disables the index. Each entry takes
+// 8 bytes (the default 8 entries: 64 B); size it to the blocks the device reads, e.g. one per
+// LedStrip, one or two per Cover. Blocks beyond it still work but scan on every access.
+#ifndef EEPROM_SERVICE_INDEX_SIZE
+#define EEPROM_SERVICE_INDEX_SIZE 8
+#endif
+
+// Number of values writeBehind() can hold at once, and the largest value size in bytes.
+// Opt-in: each entry takes 12 + EEPROM_SERVICE_CACHE_VALUE_BYTES bytes of RAM (8 entries of
+// 24 bytes: 288 B), and ControllerRunner starts its "EEP" task only when the cache exists.
+// With 0, writeBehind() writes at once like write().
+#ifndef EEPROM_SERVICE_CACHE_SIZE
+#define EEPROM_SERVICE_CACHE_SIZE 0
+#endif
+#ifndef EEPROM_SERVICE_CACHE_VALUE_BYTES
+#define EEPROM_SERVICE_CACHE_VALUE_BYTES 24
+#endif
 
 /**
  * @class EepromService
  * @brief A generic, static template-based class for handling EEPROM writes and reads
  * with a wear-leveling algorithm.
+ * The first read or write of a block scans all its slots and remembers the latest one in a
+ * RAM index; later reads and writes of that block go straight to the right slot. Devices read
+ * their blocks in setup(), so the index is complete after boot. Blocks that do not fit into
+ * the index (EEPROM_SERVICE_INDEX_SIZE) keep scanning on every access.
+ * writeBehind() defers a write until the value has not changed for quietPeriodMs, so e.g.
+ * an HA slider costs one slot write instead of dozens; values equal to the stored record
+ * are never written. It needs EEPROM_SERVICE_CACHE_SIZE > 0; ControllerRunner::run() then
+ * starts a low-priority task that calls flushDue(), and ControllerRunner::enterSafeStateAndReset()
+ * calls flush().
+ * With EEPROM_WRITER_BUFFER_SIZE > 0 (default) records are programmed in the background by
+ * EepromWriter, so write() returns in microseconds instead of ~3.4 ms per byte; read()
+ * already returns the queued values.
+ * Write each block from one place only, either write() or writeBehind().
  */
 class EepromService
 {
@@ -24,49 +57,296 @@ private:
         T value; // The stored value of type T
     };
 
-public:
     /**
-     * @brief Writes a value of any type T to the EEPROM using wear leveling.
-     * @tparam T The data type of the value to write.
-     * @param startAddress The starting physical address in EEPROM for this data's block.
-     * @param value The value to write.
-     * @param slots The number of wear-leveling slots to use for this data block.
+     * @struct SlotIndex
+     * @brief Latest slot of one block, kept in RAM.
+     */
+    struct SlotIndex
+    {
+        uint16_t startAddress;
+        uint8_t slots;
+        uint8_t latestIndex; // NO_RECORD if the block has never been written.
+        uint32_t latestCounter;
+    };
+
+    static const uint8_t NO_RECORD = 0xFF;
+
+    /**
+     * @brief Reads a record, including bytes still queued in EepromWriter.
+     */
+    template <typename R>
+    static void _get(uint16_t address, R& record)
+    {
+#if EEPROM_WRITER_BUFFER_SIZE > 0
+        EepromWriter::read(address, (uint8_t*)&record, sizeof(R));
+#else
+        EEPROM.get(address, record);
+#endif
+    }
+
+    /**
+     * @brief Writes a record, queued in EepromWriter when it is enabled.
+     */
+    template <typename R>
+    static void _put(uint16_t address, const R& record, EepromWriteCallback onDone)
+    {
+#if EEPROM_WRITER_BUFFER_SIZE > 0
+        EepromWriter::write(address, (const uint8_t*)&record, sizeof(R), onDone);
+#else
+        EEPROM.put(address, record);
+        if (onDone)
+        {
+            onDone(address, sizeof(R));
+        }
+#endif
+    }
+
+#if EEPROM_SERVICE_INDEX_SIZE > 0
+    inline static SlotIndex _index[EEPROM_SERVICE_INDEX_SIZE];
+    inline static uint8_t _indexCount = 0;
+#endif
+
+    /**
+     * @brief Returns the index entry of a block, or nullptr if it is not indexed yet.
+     */
+    static SlotIndex* _findIndex(uint16_t startAddress, uint8_t slots)
+    {
+#if EEPROM_SERVICE_INDEX_SIZE > 0
+        for (uint8_t i = 0; i < _indexCount; ++i)
+        {
+            if (_index[i].startAddress == startAddress && _index[i].slots == slots)
+            {
+                return &_index[i];
+            }
+        }
+#endif
+        return nullptr;
+    }
+
+    /**
+     * @brief Adds a scanned block to the index. Returns nullptr when the index is full.
+     */
+    static SlotIndex* _addIndex(uint16_t startAddress, uint8_t slots, uint8_t latestIndex, uint32_t latestCounter)
+    {
+#if EEPROM_SERVICE_INDEX_SIZE > 0
+        if (_indexCount < EEPROM_SERVICE_INDEX_SIZE)
+        {
+            SlotIndex& entry = _index[_indexCount++];
+            entry.startAddress = startAddress;
+            entry.slots = slots;
+            entry.latestIndex = latestIndex;
+            entry.latestCounter = latestCounter;
+            return &entry;
+        }
+#endif
+        return nullptr;
+    }
+
+    /**
+     * @brief Reads every slot of a block and finds the one with the highest counter.
+     * @return The slot index, or NO_RECORD if no slot has been written.
      */
     template <typename T>
-    static void write(uint16_t startAddress, T value, uint8_t slots = 10)
+    static uint8_t _scan(uint16_t startAddress, uint8_t slots, uint32_t& latestCounter)
     {
         Record<T> record;
         const uint16_t recordSize = sizeof(record);
 
-        uint32_t latestCounter = 0;
-        uint8_t latestIndex = 0;
-        bool foundAny = false;
+        uint8_t latestIndex = NO_RECORD;
+        latestCounter = 0;
 
-        // 1. Find the last written slot
         for (uint8_t i = 0; i < slots; ++i)
         {
-            EEPROM.get(startAddress + i * recordSize, record);
+            _get(startAddress + i * recordSize, record);
 
             if (record.writeCounter != 0xFFFFFFFF)
             {
-                if (!foundAny || (int32_t)(record.writeCounter - latestCounter) > 0)
+                if (latestIndex == NO_RECORD || (int32_t)(record.writeCounter - latestCounter) > 0)
                 {
                     latestCounter = record.writeCounter;
                     latestIndex = i;
                 }
-                foundAny = true;
             }
         }
 
-        // 2. Prepare and write the new record in the next slot
-        uint8_t nextIndex = foundAny ? (latestIndex + 1) % slots : 0;
+        return latestIndex;
+    }
+
+    /**
+     * @brief Returns the index entry of a block, scanning and indexing it on first use.
+     * Without a free index entry the block is scanned and nullptr is returned.
+     * The index is shared by all tasks, so it is only accessed with interrupts disabled;
+     * the scan itself runs with interrupts enabled.
+     */
+    template <typename T>
+    static SlotIndex* _lookup(uint16_t startAddress, uint8_t slots, uint8_t& latestIndex, uint32_t& latestCounter)
+    {
+        SlotIndex* entry;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            entry = _findIndex(startAddress, slots);
+            if (entry != nullptr)
+            {
+                latestIndex = entry->latestIndex;
+                latestCounter = entry->latestCounter;
+            }
+        }
+        if (entry != nullptr)
+        {
+            return entry;
+        }
+
+        latestIndex = _scan<T>(startAddress, slots, latestCounter);
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            // Another task may have indexed the block during the scan.
+            entry = _findIndex(startAddress, slots);
+            if (entry != nullptr)
+            {
+                latestIndex = entry->latestIndex;
+                latestCounter = entry->latestCounter;
+            }
+            else
+            {
+                entry = _addIndex(startAddress, slots, latestIndex, latestCounter);
+            }
+        }
+        return entry;
+    }
+
+    /**
+     * @struct PendingWrite
+     * @brief A value held by writeBehind(), size 0 marks a free entry.
+     */
+    struct PendingWrite
+    {
+        uint16_t startAddress;
+        uint8_t slots;
+        uint8_t size;
+        bool dirty;
+        uint8_t version; // Incremented on every change, so a flush does not lose a newer value.
+        unsigned long changedAt;
+        void (*persist)(uint16_t startAddress, uint8_t slots, const uint8_t* value);
+        uint8_t value[EEPROM_SERVICE_CACHE_VALUE_BYTES];
+    };
+
+#if EEPROM_SERVICE_CACHE_SIZE > 0
+    inline static PendingWrite _pending[EEPROM_SERVICE_CACHE_SIZE];
+#endif
+
+    /**
+     * @brief Writes a value held by writeBehind() unless the latest record already has it.
+     */
+    template <typename T>
+    static void _persist(uint16_t startAddress, uint8_t slots, const uint8_t* bytes)
+    {
+        T value;
+        memcpy(&value, bytes, sizeof(T));
+
+        uint8_t latestIndex;
+        uint32_t latestCounter;
+        _lookup<T>(startAddress, slots, latestIndex, latestCounter);
+        if (latestIndex != NO_RECORD)
+        {
+            Record<T> record;
+            _get(startAddress + latestIndex * sizeof(Record<T>), record);
+            if (memcmp(&record.value, &value, sizeof(T)) == 0)
+            {
+                return;
+            }
+        }
+
+        write<T>(startAddress, value, slots);
+    }
+
+    /**
+     * @brief Writes one pending entry if it is dirty and, unless forced, quiet long enough.
+     */
+    static void _flushEntry(PendingWrite& entry, bool force)
+    {
+        uint8_t value[EEPROM_SERVICE_CACHE_VALUE_BYTES];
+        uint8_t version;
+        bool due = false;
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if (entry.size > 0 && entry.dirty && (force || millis() - entry.changedAt >= quietPeriodMs))
+            {
+                memcpy(value, entry.value, entry.size);
+                version = entry.version;
+                due = true;
+            }
+        }
+
+        if (!due)
+        {
+            return;
+        }
+
+        // Slow, runs with interrupts enabled. The entry stays dirty until the write is done, so
+        // a flush() that preempts this one still writes it.
+        entry.persist(entry.startAddress, entry.slots, value);
+
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if (entry.version == version)
+            {
+                entry.dirty = false;
+            }
+        }
+    }
+
+public:
+    // Time a writeBehind() value must stay unchanged before it is written.
+    inline static unsigned long quietPeriodMs = 2000;
+
+    /**
+     * @brief Returns the number of EEPROM bytes taken by one wear-leveled block.
+     * Use it to lay out consecutive blocks without overlaps.
+     * @tparam T The data type stored in the block.
+     * @param slots The number of wear-leveling slots of the block.
+     */
+    template <typename T>
+    static constexpr uint16_t blockSize(uint8_t slots = 10)
+    {
+        return slots * sizeof(Record<T>);
+    }
+
+    /**
+     * @brief Writes a value of any type T to the EEPROM using wear leveling.
+     * @tparam T The data type of the value to write.
+     * @param startAddress The starting physical address in EEPROM for this data's block.
+     * @param value The value to write.
+     * @param slots The number of wear-leveling slots to use for this data block.
+     * @param onDone Optional, called once the record is in the EEPROM; with EepromWriter
+     * from its interrupt, see EepromWriteCallback.
+     */
+    template <typename T>
+    static void write(uint16_t startAddress, const T& value, uint8_t slots = 10, EepromWriteCallback onDone = nullptr)
+    {
+        uint8_t latestIndex;
+        uint32_t latestCounter;
+        SlotIndex* entry = _lookup<T>(startAddress, slots, latestIndex, latestCounter);
+
+        // Write the new record in the slot after the latest one
+        uint8_t nextIndex = latestIndex != NO_RECORD ? (latestIndex + 1) % slots : 0;
 
         Record<T> newRecord = {
             .writeCounter = latestCounter + 1,
             .value = value
         };
 
-        EEPROM.put(startAddress + nextIndex * recordSize, newRecord);
+        _put(startAddress + nextIndex * sizeof(Record<T>), newRecord, onDone);
+
+        if (entry != nullptr)
+        {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+            {
+                entry->latestIndex = nextIndex;
+                entry->latestCounter = newRecord.writeCounter;
+            }
+        }
     }
 
     /**
@@ -80,30 +360,129 @@ public:
     template <typename T>
     static T read(uint16_t startAddress, T defaultValue = 0, uint8_t slots = 10)
     {
+#if EEPROM_SERVICE_CACHE_SIZE > 0
+        // A writeBehind() value not written yet is newer than the EEPROM.
+        T pendingValue;
+        bool pending = false;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            for (PendingWrite& entry : _pending)
+            {
+                if (entry.size == sizeof(T) && entry.dirty && entry.startAddress == startAddress)
+                {
+                    memcpy(&pendingValue, entry.value, sizeof(T));
+                    pending = true;
+                    break;
+                }
+            }
+        }
+        if (pending)
+        {
+            return pendingValue;
+        }
+#endif
+
+        uint8_t latestIndex;
+        uint32_t latestCounter;
+        _lookup<T>(startAddress, slots, latestIndex, latestCounter);
+
+        if (latestIndex == NO_RECORD)
+        {
+            return defaultValue;
+        }
+
         Record<T> record;
-        const uint16_t recordSize = sizeof(record);
+        _get(startAddress + latestIndex * sizeof(Record<T>), record);
+        return record.value;
+    }
 
-        uint32_t latestCounter = 0;
-        T latestValue = defaultValue;
-        bool foundAny = false;
+    /**
+     * @brief Stores a value for a deferred write() and returns at once. The value is written
+     * after it has stayed unchanged for quietPeriodMs, or by flush(). Safe from any task;
+     * read() returns the held value meanwhile. Falls back to an immediate write() when all
+     * EEPROM_SERVICE_CACHE_SIZE entries are taken (always, with the cache disabled).
+     * @tparam T The data type of the value, at most EEPROM_SERVICE_CACHE_VALUE_BYTES bytes.
+     * @param startAddress The starting physical address in EEPROM for this data's block.
+     * @param value The value to write.
+     * @param slots The number of wear-leveling slots to use for this data block.
+     */
+    template <typename T>
+    static void writeBehind(uint16_t startAddress, const T& value, uint8_t slots = 10)
+    {
+        static_assert(sizeof(T) <= EEPROM_SERVICE_CACHE_VALUE_BYTES, "Increase EEPROM_SERVICE_CACHE_VALUE_BYTES");
 
-        // Find the slot with the highest counter and return its value
-        for (uint8_t i = 0; i < slots; ++i)
+        bool cached = false;
+#if EEPROM_SERVICE_CACHE_SIZE > 0
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
         {
-            EEPROM.get(startAddress + i * recordSize, record);
+            PendingWrite* entry = nullptr;
+            for (PendingWrite& pending : _pending)
+            {
+                if (pending.size > 0 && pending.startAddress == startAddress)
+                {
+                    entry = &pending;
+                    break;
+                }
+                if (pending.size == 0 && entry == nullptr)
+                {
+                    entry = &pending;
+                }
+            }
 
-            if (record.writeCounter != 0xFFFFFFFF)
+            if (entry != nullptr)
             {
-                if (!foundAny || (int32_t)(record.writeCounter - latestCounter) > 0)
+                // A repeated value keeps its quiet period running.
+                if (entry->size == 0 || !entry->dirty || memcmp(entry->value, &value, sizeof(T)) != 0)
                 {
-                    latestCounter = record.writeCounter;
-                    latestValue = record.value;
+                    entry->startAddress = startAddress;
+                    entry->slots = slots;
+                    entry->size = sizeof(T);
+                    entry->persist = _persist<T>;
+                    memcpy(entry->value, &value, sizeof(T));
+                    entry->dirty = true;
+                    entry->version++;
+                    entry->changedAt = millis();
                 }
-                foundAny = true;
+                cached = true;
             }
         }
+#endif
 
-        return latestValue;
+        if (!cached)
+        {
+            write<T>(startAddress, value, slots);
+        }
+    }
+
+    /**
+     * @brief Writes the writeBehind() values that have been quiet for quietPeriodMs.
+     * Called periodically by the low-priority "EEP" task of ControllerRunner.
+     */
+    static void flushDue()
+    {
+#if EEPROM_SERVICE_CACHE_SIZE > 0
+        for (PendingWrite& entry : _pending)
+        {
+            _flushEntry(entry, false);
+        }
+#endif
+    }
+
+    /**
+     * @brief Writes all writeBehind() values now and waits until every queued record is in
+     * the EEPROM, for shutdown and safe-state paths. Works with interrupts disabled.
+     */
+    static void flush()
+    {
+#if EEPROM_SERVICE_CACHE_SIZE > 0
+        for (PendingWrite& entry : _pending)
+        {
+            _flushEntry(entry, true);
+        }
+#endif
+#if EEPROM_WRITER_BUFFER_SIZE > 0
+        EepromWriter::flush();
+#endif
     }
 };
 
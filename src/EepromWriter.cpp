@@ -0,0 +1,238 @@
+#include "EepromWriter.h"
+
+#if EEPROM_WRITER_BUFFER_SIZE > 0
+#include <Arduino_FreeRTOS.h>
+#include <EEPROM.h>
+
+static_assert((EEPROM_WRITER_BUFFER_SIZE & (EEPROM_WRITER_BUFFER_SIZE - 1)) == 0 && EEPROM_WRITER_BUFFER_SIZE <= 128,
+              "EEPROM_WRITER_BUFFER_SIZE must be a power of two, at most 128");
+static_assert((EEPROM_WRITER_MAX_REQUESTS & (EEPROM_WRITER_MAX_REQUESTS - 1)) == 0 && EEPROM_WRITER_MAX_REQUESTS <= 128,
+              "EEPROM_WRITER_MAX_REQUESTS must be a power of two, at most 128");
+
+// Unchanged bytes skipped per interrupt, bounds the time spent in one interrupt.
+static const uint8_t MAX_SKIPS_PER_INTERRUPT = 16;
+
+/**
+ * @struct WriteRequest
+ * @brief One queued write; its data follows the data of the previous request in s_data.
+ */
+struct WriteRequest
+{
+    uint16_t address;
+    uint16_t size;
+    EepromWriteCallback onDone;
+};
+
+// Byte ring and request ring. Free-running 8-bit indices, masked on access.
+static uint8_t s_data[EEPROM_WRITER_BUFFER_SIZE];
+static volatile uint8_t s_dataHead = 0;
+static volatile uint8_t s_dataTail = 0;
+static WriteRequest s_requests[EEPROM_WRITER_MAX_REQUESTS];
+static volatile uint8_t s_requestHead = 0;
+static volatile uint8_t s_requestTail = 0;
+static volatile uint16_t s_written = 0; // Bytes of the oldest request already taken from the ring.
+
+static uint8_t data_free()
+{
+    return EEPROM_WRITER_BUFFER_SIZE - (uint8_t)(s_dataHead - s_dataTail);
+}
+
+/**
+ * @brief Starts programming the next changed byte, or disables the interrupt when done.
+ * Runs in the interrupt, or with interrupts disabled from flush(). EEPE must be clear.
+ */
+static void service()
+{
+    uint8_t skips = 0;
+    while (s_requestHead != s_requestTail)
+    {
+        WriteRequest& request = s_requests[s_requestTail & (EEPROM_WRITER_MAX_REQUESTS - 1)];
+        if (s_written == request.size)
+        {
+            // Every byte of the oldest request has been programmed.
+            s_requestTail++;
+            s_written = 0;
+            if (request.onDone)
+            {
+                request.onDone(request.address, request.size);
+            }
+            continue;
+        }
+
+        uint16_t address = request.address + s_written;
+        uint8_t value = s_data[s_dataTail & (EEPROM_WRITER_BUFFER_SIZE - 1)];
+        s_dataTail++;
+        s_written++;
+
+        EEAR = address;
+        EECR |= _BV(EERE);
+        if (EEDR == value)
+        {
+            if (++skips < MAX_SKIPS_PER_INTERRUPT)
+            {
+                continue;
+            }
+            // Come back on the next interrupt, which fires at once while EEPE is clear.
+            return;
+        }
+
+        EEDR = value;
+        EECR |= _BV(EEMPE);
+        EECR |= _BV(EEPE);
+        return;
+    }
+
+    EECR &= ~_BV(EERIE);
+}
+
+ISR(EE_READY_vect)
+{
+    service();
+}
+
+/**
+ * @brief Runs the writer without its interrupt until the predicate is met. Only for callers
+ * that run with interrupts disabled.
+ */
+template <typename Predicate>
+static void service_until(Predicate done)
+{
+    while (!done())
+    {
+        if (!(EECR & _BV(EEPE)))
+        {
+            service();
+        }
+    }
+}
+
+/**
+ * @brief Queues one request of at most EEPROM_WRITER_BUFFER_SIZE bytes, waiting for space.
+ */
+static void enqueue(uint16_t address, const uint8_t* data, uint8_t size, EepromWriteCallback onDone)
+{
+    for (;;)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        if (data_free() >= size && (uint8_t)(s_requestHead - s_requestTail) < EEPROM_WRITER_MAX_REQUESTS)
+        {
+            s_requests[s_requestHead & (EEPROM_WRITER_MAX_REQUESTS - 1)] = WriteRequest{address, size, onDone};
+            for (uint16_t i = 0; i < size; ++i)
+            {
+                s_data[s_dataHead & (EEPROM_WRITER_BUFFER_SIZE - 1)] = data[i];
+                s_dataHead++;
+            }
+            s_requestHead++;
+            EECR |= _BV(EERIE);
+            SREG = sreg;
+            return;
+        }
+
+        // Queue full: with interrupts disabled nobody else will drain it.
+        if (!(sreg & _BV(SREG_I)) && !(EECR & _BV(EEPE)))
+        {
+            service();
+        }
+        SREG = sreg;
+
+        // A running task sleeps while the interrupt frees space (3.4 ms per byte), so it does
+        // not starve lower priority tasks; before the scheduler it polls.
+        if ((sreg & _BV(SREG_I)) && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        {
+            vTaskDelay(1);
+        }
+    }
+}
+
+void EepromWriter::write(uint16_t address, const uint8_t* data, uint16_t size, EepromWriteCallback onDone)
+{
+    // Larger writes go through the queue in buffer-sized pieces, the callback follows the last.
+    while (size > EEPROM_WRITER_BUFFER_SIZE)
+    {
+        enqueue(address, data, EEPROM_WRITER_BUFFER_SIZE, nullptr);
+        address += EEPROM_WRITER_BUFFER_SIZE;
+        data += EEPROM_WRITER_BUFFER_SIZE;
+        size -= EEPROM_WRITER_BUFFER_SIZE;
+    }
+
+    if (size > 0)
+    {
+        enqueue(address, data, size, onDone);
+    }
+}
+
+void EepromWriter::read(uint16_t address, uint8_t* data, uint16_t size)
+{
+    // Pause the writer so the EEPROM and the queue cannot change during the copy. Waits for
+    // at most one byte being programmed (3.4 ms); a write() from another task may re-enable
+    // the interrupt meanwhile, so check again with interrupts disabled.
+    uint8_t sreg = SREG;
+    for (;;)
+    {
+        cli();
+        EECR &= ~_BV(EERIE);
+        if (!(EECR & _BV(EEPE)))
+        {
+            break;
+        }
+        SREG = sreg;
+        while (EECR & _BV(EEPE))
+        {
+        }
+    }
+
+    for (uint16_t i = 0; i < size; ++i)
+    {
+        data[i] = EEPROM.read(address + i);
+    }
+
+    // Apply the queued bytes, oldest first, so the newest write wins.
+    uint8_t dataIndex = s_dataTail;
+    uint16_t offset = s_written;
+    for (uint8_t r = s_requestTail; r != s_requestHead; ++r)
+    {
+        const WriteRequest& request = s_requests[r & (EEPROM_WRITER_MAX_REQUESTS - 1)];
+        for (; offset < request.size; ++offset, ++dataIndex)
+        {
+            uint16_t target = request.address + offset;
+            if (target >= address && target < address + size)
+            {
+                data[target - address] = s_data[dataIndex & (EEPROM_WRITER_BUFFER_SIZE - 1)];
+            }
+        }
+        offset = 0;
+    }
+
+    if (s_requestHead != s_requestTail)
+    {
+        EECR |= _BV(EERIE);
+    }
+    SREG = sreg;
+}
+
+bool EepromWriter::isIdle()
+{
+    uint8_t sreg = SREG;
+    cli();
+    bool idle = s_requestHead == s_requestTail && !(EECR & _BV(EEPE));
+    SREG = sreg;
+    return idle;
+}
+
+void EepromWriter::flush()
+{
+    if (SREG & _BV(SREG_I))
+    {
+        while (!isIdle())
+        {
+        }
+        return;
+    }
+
+    service_until([] { return s_requestHead == s_requestTail; });
+    while (EECR & _BV(EEPE))
+    {
+    }
+}
+#endif
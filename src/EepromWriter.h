@@ -0,0 +1,60 @@
+#ifndef AHA_DEVICES_EEPROM_WRITER_H
+#define AHA_DEVICES_EEPROM_WRITER_H
+
+#include <Arduino.h>
+
+// Bytes that can wait for the EEPROM, must be a power of two (at most 128); 0 makes
+// EepromService write synchronously through the EEPROM library instead.
+#ifndef EEPROM_WRITER_BUFFER_SIZE
+#define EEPROM_WRITER_BUFFER_SIZE 64
+#endif
+
+// Writes that can wait at the same time, must be a power of two (at most 128).
+#ifndef EEPROM_WRITER_MAX_REQUESTS
+#define EEPROM_WRITER_MAX_REQUESTS 8
+#endif
+
+/**
+ * @brief Called from the EEPROM-ready interrupt when the last byte of a write is programmed.
+ * Keep it short, e.g. set a flag or notify a task.
+ */
+typedef void (*EepromWriteCallback)(uint16_t address, uint16_t size);
+
+#if EEPROM_WRITER_BUFFER_SIZE > 0
+/**
+ * @brief Asynchronous EEPROM writes, the backend of EepromService.
+ * write() queues the bytes and returns; the EEPROM-ready interrupt programs them one by one
+ * (3.4 ms each) and skips bytes that already hold the value. read() sees queued bytes, so
+ * data is coherent before it reaches the EEPROM. When the queue is full, write() waits for
+ * space: a task sleeps a tick at a time, with interrupts disabled it services the EEPROM itself.
+ * It must be the only EEPROM writer: do not use EEPROM.write/put/update next to it.
+ */
+namespace EepromWriter
+{
+    /**
+     * @brief Queues a write. Safe from any task. Writes larger than EEPROM_WRITER_BUFFER_SIZE
+     * are queued in buffer-sized pieces, so they wait for the queue to drain piece by piece.
+     * @param onDone Optional callback, see EepromWriteCallback.
+     */
+    void write(uint16_t address, const uint8_t* data, uint16_t size, EepromWriteCallback onDone = nullptr);
+
+    /**
+     * @brief Reads bytes as they will be once all queued writes are done. Waits for at most
+     * the byte being programmed, then copies with interrupts disabled.
+     */
+    void read(uint16_t address, uint8_t* data, uint16_t size);
+
+    /**
+     * @brief Returns true if no write is queued or in progress.
+     */
+    bool isIdle();
+
+    /**
+     * @brief Waits until every queued byte is programmed. Works with interrupts disabled,
+     * e.g. on the way to a reset.
+     */
+    void flush();
+}
+#endif
+
+#endif // AHA_DEVICES_EEPROM_WRITER_H
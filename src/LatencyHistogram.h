@@ -0,0 +1,114 @@
+#ifndef AHA_DEVICES_LATENCY_HISTOGRAM_H
+#define AHA_DEVICES_LATENCY_HISTOGRAM_H
+
+#include <Arduino.h>
+
+// Number of log2 buckets of LatencyHistogram. Bucket k counts durations in [2^k, 2^(k+1)) us
+// (bucket 0 also holds 0), the last bucket everything above; 16 buckets reach 32..65 ms and take
+// 32 bytes of RAM.
+#ifndef LATENCY_HISTOGRAM_BUCKETS
+#define LATENCY_HISTOGRAM_BUCKETS 16
+#endif
+
+/**
+ * @class BasicLatencyHistogram
+ * @brief Fixed-size log2-bucket histogram of durations, in whatever unit the caller records
+ * (LatencyHistogram: microseconds, TaskMonitor: ProfilingClock cycles when enabled).
+ * Percentiles are estimated by linear interpolation inside a bucket, so they are accurate
+ * to within the bucket width (a factor of two) but cost no extra RAM.
+ * Not synchronized: record and read from the same task, or guard the calls.
+ * @tparam BUCKETS Number of buckets, at most 32.
+ */
+template <uint8_t BUCKETS>
+class BasicLatencyHistogram
+{
+    static_assert(BUCKETS >= 2 && BUCKETS <= 32, "BasicLatencyHistogram needs 2 to 32 buckets");
+
+public:
+    BasicLatencyHistogram() { reset(); }
+
+    void reset()
+    {
+        memset(_counts, 0, sizeof(_counts));
+    }
+
+    void record(uint32_t duration)
+    {
+        uint8_t bucket = bucketOf(duration);
+        if (_counts[bucket] != 0xFFFF) _counts[bucket]++;
+    }
+
+    uint32_t count() const
+    {
+        uint32_t samples = 0;
+        for (uint8_t i = 0; i < BUCKETS; ++i) samples += _counts[i];
+        return samples;
+    }
+
+    uint16_t bucketCount(uint8_t bucket) const { return bucket < BUCKETS ? _counts[bucket] : 0; }
+
+    /**
+     * @brief Returns the estimated duration below which the given share of samples fall.
+     * @param permille The percentile in permille, e.g. 500 for p50 or 990 for p99.
+     * @return The estimate in the recorded unit, 0 if nothing was recorded.
+     */
+    uint32_t percentile(uint16_t permille) const
+    {
+        uint32_t samples = count();
+        if (samples == 0) return 0;
+
+        // Rank of the wanted sample, rounded up so that p100 is the last sample.
+        uint32_t rank = (samples * permille + 999) / 1000;
+        if (rank == 0) rank = 1;
+
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < BUCKETS; ++i)
+        {
+            if (_counts[i] == 0) continue;
+            if (seen + _counts[i] >= rank)
+            {
+                uint32_t lower = lowerBound(i);
+                uint32_t width = lowerBound(i + 1) - lower;
+                return lower + width * (rank - seen) / _counts[i];
+            }
+            seen += _counts[i];
+        }
+        return lowerBound(BUCKETS);
+    }
+
+    uint32_t p50() const { return percentile(500); }
+    uint32_t p95() const { return percentile(950); }
+    uint32_t p99() const { return percentile(990); }
+
+    /**
+     * @brief Returns the bucket index of a duration.
+     */
+    static uint8_t bucketOf(uint32_t duration)
+    {
+        uint8_t bucket = 0;
+        while (duration > 1 && bucket < BUCKETS - 1)
+        {
+            duration >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    /**
+     * @brief Returns the smallest duration counted in a bucket (bucket 0 starts at 0).
+     */
+    static uint32_t lowerBound(uint8_t bucket)
+    {
+        return bucket == 0 ? 0 : bucket >= 32 ? 0xFFFFFFFF : (uint32_t)1 << bucket;
+    }
+
+private:
+    uint16_t _counts[BUCKETS]; // Saturating per-bucket counts.
+};
+
+/**
+ * @brief Histogram of durations in microseconds.
+ */
+typedef BasicLatencyHistogram<LATENCY_HISTOGRAM_BUCKETS> LatencyHistogram;
+
+#endif // AHA_DEVICES_LATENCY_HISTOGRAM_H
@@ -0,0 +1,221 @@
+#define DEBUG_MODULE LogModule::DIAGNOSTICS
+#include "LatencyTrace.h"
+
+#ifdef LATENCYTRACE
+#include <Arduino_FreeRTOS.h>
+
+// Edge-to-event times include the click delay (375 ms) and long presses (1.2 s), beyond the
+// range of a microsecond histogram, so that stage is recorded in units of 64 us.
+static const uint8_t STAGE_SHIFT[LATENCY_STAGE_COUNT] = {6, 0, 0, 6};
+
+/**
+ * @struct ButtonTrace
+ * @brief Timestamps of the gesture in flight and the distributions of one button.
+ */
+struct ButtonTrace
+{
+    uint16_t buttonId;
+    bool used;
+    bool edgePending; // An edge was seen and no event has been dispatched yet.
+    uint32_t edgeUs;
+    uint32_t eventUs;
+    uint32_t dispatchUs;
+    TaskHandle_t dispatchTask; // Task running the button callback, NULL outside of it.
+    LatencyHistogram stages[LATENCY_STAGE_COUNT];
+};
+
+static ButtonTrace s_buttons[LATENCY_TRACE_MAX_BUTTONS];
+
+/**
+ * @brief Returns the trace of a button, claiming a free slot on first use.
+ */
+static ButtonTrace* find_button(uint16_t buttonId)
+{
+    for (ButtonTrace& button : s_buttons)
+    {
+        if (!button.used)
+        {
+            button.used = true;
+            button.buttonId = buttonId;
+            return &button;
+        }
+        if (button.buttonId == buttonId)
+        {
+            return &button;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the button whose callback runs in the calling task, or nullptr. Buttons
+ * polled by different tasks may dispatch at the same time.
+ */
+static ButtonTrace* dispatching_button()
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (ButtonTrace& button : s_buttons)
+    {
+        if (button.used && button.dispatchTask == self)
+        {
+            return &button;
+        }
+    }
+    return nullptr;
+}
+
+static void record(ButtonTrace* button, LatencyStage stage, uint32_t durationUs)
+{
+    button->stages[stage].record(durationUs >> STAGE_SHIFT[stage]);
+}
+
+void LatencyTrace::edge(uint16_t buttonId)
+{
+    uint32_t now = micros();
+    taskENTER_CRITICAL();
+    ButtonTrace* button = find_button(buttonId);
+    if (button != nullptr && !button->edgePending)
+    {
+        button->edgePending = true;
+        button->edgeUs = now;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void LatencyTrace::event(uint16_t buttonId)
+{
+    uint32_t now = micros();
+    taskENTER_CRITICAL();
+    ButtonTrace* button = find_button(buttonId);
+    if (button != nullptr)
+    {
+        button->eventUs = now;
+        if (button->edgePending)
+        {
+            record(button, LATENCY_EDGE_TO_EVENT, now - button->edgeUs);
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void LatencyTrace::idle(uint16_t buttonId)
+{
+    taskENTER_CRITICAL();
+    ButtonTrace* button = find_button(buttonId);
+    if (button != nullptr)
+    {
+        button->edgePending = false;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void LatencyTrace::dispatch(uint16_t buttonId)
+{
+    uint32_t now = micros();
+    taskENTER_CRITICAL();
+    ButtonTrace* button = find_button(buttonId);
+    if (button != nullptr)
+    {
+        button->dispatchUs = now;
+        button->dispatchTask = xTaskGetCurrentTaskHandle();
+        record(button, LATENCY_EVENT_TO_DISPATCH, now - button->eventUs);
+    }
+    taskEXIT_CRITICAL();
+}
+
+void LatencyTrace::dispatchDone()
+{
+    taskENTER_CRITICAL();
+    ButtonTrace* button = dispatching_button();
+    if (button != nullptr)
+    {
+        // The next gesture starts with the next edge.
+        button->edgePending = false;
+        button->dispatchTask = NULL;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void LatencyTrace::actuated()
+{
+    uint32_t now = micros();
+    taskENTER_CRITICAL();
+    ButtonTrace* button = dispatching_button();
+    if (button != nullptr)
+    {
+        record(button, LATENCY_DISPATCH_TO_ACTUATE, now - button->dispatchUs);
+        if (button->edgePending)
+        {
+            record(button, LATENCY_TOTAL, now - button->edgeUs);
+        }
+
+        // One callback may switch several outputs, only the first one counts.
+        button->edgePending = false;
+        button->dispatchTask = NULL;
+    }
+    taskEXIT_CRITICAL();
+}
+
+bool LatencyTrace::getStats(uint8_t slot, LatencyTraceStats& stats)
+{
+    if (slot >= LATENCY_TRACE_MAX_BUTTONS)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    ButtonTrace& button = s_buttons[slot];
+    bool used = button.used;
+    if (used)
+    {
+        stats.buttonId = button.buttonId;
+        for (uint8_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+        {
+            const LatencyHistogram& histogram = button.stages[stage];
+            stats.count[stage] = histogram.count();
+            stats.p50Us[stage] = histogram.p50() << STAGE_SHIFT[stage];
+            stats.p95Us[stage] = histogram.p95() << STAGE_SHIFT[stage];
+            stats.p99Us[stage] = histogram.p99() << STAGE_SHIFT[stage];
+        }
+    }
+    taskEXIT_CRITICAL();
+    return used;
+}
+
+void LatencyTrace::reset()
+{
+    taskENTER_CRITICAL();
+    for (ButtonTrace& button : s_buttons)
+    {
+        for (LatencyHistogram& histogram : button.stages)
+        {
+            histogram.reset();
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+void LatencyTrace::report()
+{
+    DPRINTLN(F("--- Button latency (us) p50/p95/p99: edge>event, event>dispatch, dispatch>write, total ---"));
+    LatencyTraceStats stats;
+    for (uint8_t slot = 0; getStats(slot, stats); ++slot)
+    {
+        DPRINT(F(" Button "));
+        DPRINT(stats.buttonId);
+        DPRINT(F(" ("));
+        DPRINT(stats.count[LATENCY_TOTAL]);
+        DPRINT(F("):"));
+        for (uint8_t stage = 0; stage < LATENCY_STAGE_COUNT; ++stage)
+        {
+            DPRINT(F(" "));
+            DPRINT(stats.p50Us[stage]);
+            DPRINT(F("/"));
+            DPRINT(stats.p95Us[stage]);
+            DPRINT(F("/"));
+            DPRINT(stats.p99Us[stage]);
+        }
+        DPRINTLN();
+    }
+}
+#endif
@@ -0,0 +1,114 @@
+#ifndef AHA_DEVICES_LATENCY_TRACE_H
+#define AHA_DEVICES_LATENCY_TRACE_H
+
+#include <Arduino.h>
+#include <Debug.h>
+
+// Number of buttons traced; each one takes about 140 bytes of RAM.
+#ifndef LATENCY_TRACE_MAX_BUTTONS
+#define LATENCY_TRACE_MAX_BUTTONS 4
+#endif
+
+#ifdef LATENCYTRACE
+#include "LatencyHistogram.h"
+
+/**
+ * @enum LatencyStage
+ * @brief Stage of the path from a button edge to the output pin.
+ */
+enum LatencyStage : uint8_t
+{
+    LATENCY_EDGE_TO_EVENT, // First edge seen by the scan until getButtonEvent() reports an event (debounce, click detection).
+    LATENCY_EVENT_TO_DISPATCH, // Event until the button callback is called.
+    LATENCY_DISPATCH_TO_ACTUATE, // Callback until the first digitalWrite of a Light/PowerSocket.
+    LATENCY_TOTAL, // Edge until digitalWrite.
+    LATENCY_STAGE_COUNT
+};
+
+/**
+ * @struct LatencyTraceStats
+ * @brief Latency distribution of one button, per stage, in microseconds.
+ */
+struct LatencyTraceStats
+{
+    uint16_t buttonId;
+    uint32_t count[LATENCY_STAGE_COUNT];
+    uint32_t p50Us[LATENCY_STAGE_COUNT];
+    uint32_t p95Us[LATENCY_STAGE_COUNT];
+    uint32_t p99Us[LATENCY_STAGE_COUNT];
+};
+
+/**
+ * @brief Button-to-actuator latency tracing (enable LATENCYTRACE in Debug.h, works in release builds).
+ * Buttons are polled, so the "edge" is the first scan that sees the new level; the time before
+ * that is at most one scan period. Only actuators switched synchronously from the button
+ * callback are attributed to the button. Each hook costs one micros() call and a table lookup.
+ */
+namespace LatencyTrace
+{
+    /**
+     * @brief A button's input changed. Only the first edge of a gesture is kept.
+     */
+    void edge(uint16_t buttonId);
+
+    /**
+     * @brief getButtonEvent() reported an event for the button.
+     */
+    void event(uint16_t buttonId);
+
+    /**
+     * @brief The button is idle again after its last edge; drops an edge that led to no event.
+     */
+    void idle(uint16_t buttonId);
+
+    /**
+     * @brief The button callback is about to run; actuations of the calling task until
+     * dispatchDone() belong to it.
+     */
+    void dispatch(uint16_t buttonId);
+
+    /**
+     * @brief The button callback returned.
+     */
+    void dispatchDone();
+
+    /**
+     * @brief An output pin was written. Records the latency of the button dispatching in the
+     * calling task, if any.
+     */
+    void actuated();
+
+    /**
+     * @brief Copies the distribution of a traced button.
+     * @param slot 0..LATENCY_TRACE_MAX_BUTTONS-1, in order of first use.
+     * @return false if the slot is unused.
+     */
+    bool getStats(uint8_t slot, LatencyTraceStats& stats);
+
+    /**
+     * @brief Clears all distributions.
+     */
+    void reset();
+
+    /**
+     * @brief Prints all distributions through DPRINT.
+     */
+    void report();
+}
+
+#define LATENCY_TRACE_EDGE(id) LatencyTrace::edge(id)
+#define LATENCY_TRACE_EVENT(id) LatencyTrace::event(id)
+#define LATENCY_TRACE_IDLE(id) LatencyTrace::idle(id)
+#define LATENCY_TRACE_DISPATCH(id) LatencyTrace::dispatch(id)
+#define LATENCY_TRACE_DISPATCH_DONE() LatencyTrace::dispatchDone()
+#define LATENCY_TRACE_ACTUATED() LatencyTrace::actuated()
+#else
+#define LATENCY_TRACE_EDGE(id)
+#define LATENCY_TRACE_EVENT(id)
+#define LATENCY_TRACE_IDLE(id)
+#define LATENCY_TRACE_DISPATCH(id)
+#define LATENCY_TRACE_DISPATCH_DONE()
+#define LATENCY_TRACE_ACTUATED()
+#endif
+
+#endif // AHA_DEVICES_LATENCY_TRACE_H
@@ -1,4 +1,12 @@
+#define DEBUG_MODULE LogModule::LEDSTRIP
 #include "LedStrip.h"
+#include "BootProfiler.h"
+#include "Bus/MqttBusLock.h"
+#ifdef TRACEPOINTS_LEDSTRIP
+#define TRACEPOINTS_ENABLED
+#endif
+#include "Trace/Tracepoint.h"
+#include "Trace/Trace.h"
 
 LedStrip* LedStrip::_head = nullptr;
 
@@ -35,6 +43,31 @@ LedStrip::LedStrip(
     _head = this;
 }
 
+LedStrip::LedStrip(
+    ModbusBus* modbusBus,
+    HALight* haLight,
+    const char* name,
+    uint8_t pin,
+    int ledGroupIndex,
+    uint16_t eepromAddr,
+    uint8_t eepromSlots,
+    uint16_t stabilizationTimeMs,
+    const char* icon
+) : LedStrip(
+    static_cast<ModbusRTUMaster*>(nullptr),
+    haLight,
+    name,
+    pin,
+    ledGroupIndex,
+    eepromAddr,
+    eepromSlots,
+    stabilizationTimeMs,
+    icon
+)
+{
+    _modbusBus = modbusBus;
+}
+
 // Destruktor
 LedStrip::~LedStrip()
 {
@@ -47,6 +80,7 @@ void LedStrip::setup()
 {
     for (LedStrip* current = _head; current != nullptr; current = current->_nextInstance)
     {
+        BOOT_PROFILE_SCOPE(F("LedStrip"), current->_haLight->uniqueId());
         current->_setup();
     }
 }
@@ -59,6 +93,31 @@ void LedStrip::loop()
     }
 }
 
+void LedStrip::onWakeRequest(void (*callback)())
+{
+    _wakeCallback = callback;
+}
+
+bool LedStrip::isAnyBusy()
+{
+    for (LedStrip* current = _head; current != nullptr; current = current->_nextInstance)
+    {
+        if (current->_state != LedStripState::IDLE)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LedStrip::_requestWake()
+{
+    if (_wakeCallback)
+    {
+        _wakeCallback();
+    }
+}
+
 LedStrip* LedStrip::_findInstance(HALight* haLight)
 {
     for (LedStrip* current = _head; current != nullptr; current = current->_nextInstance)
@@ -123,7 +182,8 @@ void LedStrip::_saveStateToEeprom()
 {
     if (_eepromAddr > 0)
     {
-        EepromService::write(_eepromAddr, _register, _eepromSlots);
+        // Deferred, so dragging a slider in HA ends in a single write.
+        EepromService::writeBehind(_eepromAddr, _register, _eepromSlots);
     }
 }
 
@@ -140,6 +200,7 @@ uint16_t LedStrip::_getMireds() const
 
 void LedStrip::_updateModbusRegisters(LedGroupCommand command = LedGroupCommand::CMD_IDLE)
 {
+    TRACE_SCOPE(TP_LEDSTRIP_MODBUS_WRITE);
     uint8_t error;
 
     if (_register.values[REG_ANIMATION_ID] == 0)
@@ -151,8 +212,7 @@ void LedStrip::_updateModbusRegisters(LedGroupCommand command = LedGroupCommand:
     {
         uint16_t regs_to_write = REGS_PER_GROUP - REG_COMMAND;
         _register.values[REG_COMMAND] = command;
-        error = _modbusMaster->writeMultipleHoldingRegisters(
-            _modbusId,
+        error = _writeRegisters(
             getRegisterAddress(REG_COMMAND),
             &_register.values[REG_COMMAND],
             regs_to_write
@@ -163,8 +223,7 @@ void LedStrip::_updateModbusRegisters(LedGroupCommand command = LedGroupCommand:
     else
     {
         uint16_t regs_to_write = REGS_PER_GROUP - REG_MODE;
-        error = _modbusMaster->writeMultipleHoldingRegisters(
-            _modbusId,
+        error = _writeRegisters(
             getRegisterAddress(REG_MODE),
             &_register.values[REG_MODE],
             regs_to_write
@@ -175,17 +234,39 @@ void LedStrip::_updateModbusRegisters(LedGroupCommand command = LedGroupCommand:
     // @Todo: if error retry??
     if (error)
     {
-        DPRINT(F("[LedStrip("));
-        DPRINT(_haLight->uniqueId());
-        DPRINT(F(")] #_updateModbusRegisters() - Błąd zapisu Modbus: "));
-        DPRINTLN(error);
+        EPRINT(F("[LedStrip("));
+        EPRINT(_haLight->uniqueId());
+        EPRINT(F(")] #_updateModbusRegisters() - Błąd zapisu Modbus: "));
+        EPRINTLN(error);
+        TPRINT(LEDSTRIP_WRITE_ERROR, _haLight->uniqueId(), error);
     }
     else
     {
         DPRINT(F("[LedStrip("));
         DPRINT(_haLight->uniqueId());
         DPRINTLN(F(")] Konfiguracja wysłana pomyślnie."));
+        TPRINT(LEDSTRIP_WRITE_OK, _haLight->uniqueId());
+    }
+}
+
+uint8_t LedStrip::_writeRegisters(uint16_t startAddress, uint16_t* buffer, uint16_t quantity)
+{
+    if (_modbusBus)
+    {
+        // Writes carry user commands, so they go ahead of the turn-off state polls.
+        return _modbusBus->writeMultipleHoldingRegisters(_modbusId, startAddress, buffer, quantity,
+                                                         ModbusBus::PRIORITY_HIGH);
+    }
+    return _modbusMaster->writeMultipleHoldingRegisters(_modbusId, startAddress, buffer, quantity);
+}
+
+uint8_t LedStrip::_readRegisters(uint16_t startAddress, uint16_t* buffer, uint16_t quantity)
+{
+    if (_modbusBus)
+    {
+        return _modbusBus->readHoldingRegisters(_modbusId, startAddress, buffer, quantity);
     }
+    return _modbusMaster->readHoldingRegisters(_modbusId, startAddress, buffer, quantity);
 }
 
 void LedStrip::_setup()
@@ -261,6 +342,7 @@ void LedStrip::_loop()
         {
             _updateModbusRegisters(LedGroupCommand::CMD_TURN_ON);
             _state = LedStripState::IDLE;
+            TRACE_EVENT(TP_LEDSTRIP_STATE, _state);
             _turnOnSequenceStartedAt = 0;
         }
         break;
@@ -280,12 +362,13 @@ void LedStrip::_loop()
         if (millis() - _turnOffModbusReadAt > 50)
         {
             uint16_t state = 0;
-            auto error = _modbusMaster->readHoldingRegisters(_modbusId, getRegisterAddress(REG_STATE), &state, 1);
+            auto error = _readRegisters(getRegisterAddress(REG_STATE), &state, 1);
             _turnOffModbusReadAt = millis();
             if (error == 0 && static_cast<LedGroupState>(state) == LedGroupState::STATE_READY_TO_TURN_OFF)
             {
                 _updateModbusRegisters(LedGroupCommand::CMD_TURN_OFF);
                 _state = LedStripState::IDLE;
+                TRACE_EVENT(TP_LEDSTRIP_STATE, _state);
                 _turnOffSequenceStartedAt = 0;
                 _turnOffModbusReadAt = 0;
             }
@@ -297,6 +380,7 @@ void LedStrip::_loop()
             DPRINTLN(F("Timeout for TURN_OFF animation reached"));
             _updateModbusRegisters(LedGroupCommand::CMD_TURN_OFF);
             _state = LedStripState::IDLE;
+            TRACE_EVENT(TP_LEDSTRIP_STATE, _state);
             _turnOffSequenceStartedAt = 0;
             _turnOffModbusReadAt = 0;
             return;
@@ -319,8 +403,14 @@ void LedStrip::executeCommand(LedGroupCommand command)
 void LedStrip::setState(bool state)
 {
     _isTurnedOn = state;
-    _haLight->setState(state, false);
+    {
+        MqttBusLock lock;
+        _haLight->setState(state, false);
+    }
     _state = state ? LedStripState::TURN_ON : LedStripState::TURN_OFF;
+    TRACE_EVENT(TP_LEDSTRIP_STATE, _state);
+
+    _requestWake();
 }
 
 bool LedStrip::getState()
@@ -331,7 +421,10 @@ bool LedStrip::getState()
 void LedStrip::setBrightness(uint8_t brightness)
 {
     _register.values[REG_BRIGHTNESS] = brightness;
-    _haLight->setBrightness(brightness, false);
+    {
+        MqttBusLock lock;
+        _haLight->setBrightness(brightness, false);
+    }
 
     if (getState())
     {
@@ -349,7 +442,10 @@ void LedStrip::setRGBColor(HALight::RGBColor color)
     _register.values[REG_R] = color.red;
     _register.values[REG_G] = color.green;
     _register.values[REG_B] = color.blue;
-    _haLight->setRGBColor(color, false);
+    {
+        MqttBusLock lock;
+        _haLight->setRGBColor(color, false);
+    }
 
     if (getState())
     {
@@ -370,7 +466,10 @@ void LedStrip::setColorTemperature(uint16_t mireds)
 
     _register.values[REG_WW] = (255 * ww_percent) / 100;
     _register.values[REG_CW] = (255 * cw_percent) / 100;
-    _haLight->setColorTemperature(mireds, false);
+    {
+        MqttBusLock lock;
+        _haLight->setColorTemperature(mireds, false);
+    }
 
     if (getState())
     {
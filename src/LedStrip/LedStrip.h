@@ -7,6 +7,7 @@
 #include "Debug.h"
 #include "EepromSerivce.h"
 #include "LedGroupModbusRegisters.h"
+#include "Bus/ModbusBus.h"
 
 struct LedStripRegisterSet
 {
@@ -29,12 +30,34 @@ public:
         const char* icon = nullptr
     );
 
+    // Same as above, but all Modbus transactions go through a shared bus arbiter task.
+    LedStrip(
+        ModbusBus* modbusBus,
+        HALight* haLight,
+        const char* name,
+        uint8_t pin,
+        int ledGroupIndex,
+        uint16_t eepromAddr = 0,
+        uint8_t eepromSlots = 10,
+        uint16_t stabilizationTimeMs = 200,
+        const char* icon = nullptr
+    );
+
     virtual ~LedStrip();
 
     // Statyczne metody setup() i loop() dla wszystkich instancji
     static void setup();
     static void loop();
 
+    // Callback invoked when a strip state change is requested, so the task running loop()
+    // can be woken (e.g. ControllerRunner::notify) instead of waiting for its next period.
+    static void onWakeRequest(void (*callback)());
+
+    // True while any strip runs its turn-on/turn-off sequence, which needs loop() every few
+    // tens of ms. Use it as isBusyFunc of an ADAPTIVE task; an EVENT task only runs the
+    // sequence steps on its timeout.
+    static bool isAnyBusy();
+
     // Publiczne API
     void setState(bool state);
     bool getState();
@@ -53,6 +76,7 @@ private:
 
     LedStrip* _nextInstance;
     ModbusRTUMaster* _modbusMaster;
+    ModbusBus* _modbusBus = nullptr;
     HALight* _haLight;
     uint8_t _pin;
     int _ledGroupIndex;
@@ -79,10 +103,14 @@ private:
     void _saveStateToEeprom();
     uint16_t _getMireds() const;
     void _updateModbusRegisters(LedGroupCommand command);
+    uint8_t _writeRegisters(uint16_t startAddress, uint16_t* buffer, uint16_t quantity);
+    uint8_t _readRegisters(uint16_t startAddress, uint16_t* buffer, uint16_t quantity);
     int getRegisterAddress(ModbusLedGroupRegisters reg) const;
 
     // -- Home assistant --
     static LedStrip* _head;
+    inline static void (*_wakeCallback)() = nullptr;
+    static void _requestWake();
     static LedStrip* _findInstance(HALight* haLight);
     static void _onStateCommand(bool state, HALight* sender);
     static void _onBrightnessCommand(uint8_t brightness, HALight* sender);
@@ -1,4 +1,8 @@
+#define DEBUG_MODULE LogModule::LIGHT
 #include "Light.h"
+#include "BootProfiler.h"
+#include "Bus/MqttBusLock.h"
+#include "LatencyTrace.h"
 
 // Initialization of the static head pointer for our linked list.
 Light* Light::_head = nullptr;
@@ -91,6 +95,7 @@ void Light::_initialize(const char* name, const char* icon) {
 void Light::setup() {
     DPRINTLN(F("Setting up all Light instances..."));
     for (Light* current = _head; current != nullptr; current = current->_nextInstance) {
+        BOOT_PROFILE_SCOPE(F("Light"), current->_haLight->uniqueId());
         current->_setup();
     }
 }
@@ -135,9 +140,11 @@ void Light::setState(bool state) {
     DPRINTLN(F(")"));
 
     digitalWrite(_pin, state ? HIGH : LOW);
+    LATENCY_TRACE_ACTUATED();
     _currentState = state;
 
     if (_haLight) {
+        MqttBusLock lock;
         _haLight->setState(state, true);
     }
 }
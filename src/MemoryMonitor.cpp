@@ -0,0 +1,128 @@
+#define DEBUG_MODULE LogModule::DIAGNOSTICS
+#include "MemoryMonitor.h"
+
+#include <Arduino_FreeRTOS.h>
+
+// avr-libc malloc state, see the "Memory Areas and Using malloc()" chapter of the avr-libc manual.
+struct __freelist
+{
+    size_t sz; // Usable size of the block (without this header field).
+    struct __freelist* nx;
+};
+
+extern char __heap_start;
+extern char* __brkval;
+extern char* __malloc_heap_end;
+extern size_t __malloc_margin;
+extern struct __freelist* __flp;
+
+static const uint8_t CANARY = 0xC5;
+
+static uint16_t s_minFreeBytes = 0xFFFF;
+
+/**
+ * @brief Returns the current top of the heap.
+ */
+static char* heap_top()
+{
+    return __brkval != nullptr ? __brkval : &__heap_start;
+}
+
+/**
+ * @brief Returns the address the heap may grow up to.
+ * With __malloc_heap_end unset, malloc grows up to the main stack minus __malloc_margin.
+ */
+static char* heap_limit()
+{
+    return __malloc_heap_end != nullptr ? __malloc_heap_end : (char*)(RAMEND - __malloc_margin);
+}
+
+void MemoryMonitor::begin()
+{
+    uint8_t marker;
+    char* stackBottom = (char*)&marker - 16; // Leave room for this frame.
+
+    for (char* p = heap_top(); p < stackBottom; ++p)
+    {
+        *p = CANARY;
+    }
+}
+
+void MemoryMonitor::sample(MemoryStats& stats)
+{
+    uint16_t freeListBytes = 0;
+    uint16_t largestListBlock = 0;
+    uint8_t freeListBlocks = 0;
+
+    taskENTER_CRITICAL();
+    char* top = heap_top();
+    char* limit = heap_limit();
+    for (struct __freelist* block = __flp; block != nullptr; block = block->nx)
+    {
+        freeListBytes += block->sz;
+        if (block->sz > largestListBlock) largestListBlock = block->sz;
+        if (freeListBlocks < 0xFF) freeListBlocks++;
+    }
+    taskEXIT_CRITICAL();
+
+    uint16_t gap = limit > top ? limit - top : 0;
+
+    // Count untouched canary bytes upward from the heap top.
+    uint16_t margin = 0;
+    for (const char* p = top; p < (const char*)RAMEND && *(const uint8_t*)p == CANARY; ++p)
+    {
+        margin++;
+    }
+
+    stats.heapUsedBytes = top - &__heap_start;
+    stats.freeBytes = gap + freeListBytes;
+    stats.largestFreeBlock = gap > largestListBlock ? gap : largestListBlock;
+    stats.freeListBytes = freeListBytes;
+    stats.freeListBlocks = freeListBlocks;
+    stats.fragmentationPermille = stats.freeBytes > 0 ?
+        1000 - (uint16_t)((uint32_t)stats.largestFreeBlock * 1000 / stats.freeBytes) : 0;
+    stats.stackMarginBytes = margin;
+
+    taskENTER_CRITICAL();
+    if (stats.freeBytes < s_minFreeBytes) s_minFreeBytes = stats.freeBytes;
+    stats.minFreeBytes = s_minFreeBytes;
+    taskEXIT_CRITICAL();
+}
+
+uint16_t MemoryMonitor::freeBytes()
+{
+    MemoryStats stats;
+    sample(stats);
+    return stats.freeBytes;
+}
+
+uint16_t MemoryMonitor::minFreeBytes()
+{
+    taskENTER_CRITICAL();
+    uint16_t minFree = s_minFreeBytes;
+    taskEXIT_CRITICAL();
+    return minFree;
+}
+
+void MemoryMonitor::report()
+{
+    MemoryStats stats;
+    sample(stats);
+
+    DPRINT(F("Heap used/free/largest/min: "));
+    DPRINT(stats.heapUsedBytes);
+    DPRINT(F("/"));
+    DPRINT(stats.freeBytes);
+    DPRINT(F("/"));
+    DPRINT(stats.largestFreeBlock);
+    DPRINT(F("/"));
+    DPRINTLN(stats.minFreeBytes);
+    DPRINT(F("Free list blocks/bytes: "));
+    DPRINT(stats.freeListBlocks);
+    DPRINT(F("/"));
+    DPRINT(stats.freeListBytes);
+    DPRINT(F(", fragmentation: "));
+    DPRINT(stats.fragmentationPermille / 10);
+    DPRINT(F("%, stack margin: "));
+    DPRINTLN(stats.stackMarginBytes);
+}
@@ -0,0 +1,58 @@
+#ifndef AHA_DEVICES_MEMORY_MONITOR_H
+#define AHA_DEVICES_MEMORY_MONITOR_H
+
+#include <Arduino.h>
+#include <Debug.h>
+
+/**
+ * @struct MemoryStats
+ * @brief Snapshot of the avr-libc malloc heap. All sizes in bytes.
+ */
+struct MemoryStats
+{
+    uint16_t heapUsedBytes; // From the start of the heap to its top (__brkval), including free blocks.
+    uint16_t freeBytes; // Free-list blocks plus the unallocated gap above the heap top.
+    uint16_t largestFreeBlock; // Largest single allocation that can still succeed.
+    uint16_t freeListBytes; // Free bytes trapped in the free list below the heap top.
+    uint8_t freeListBlocks;
+    uint16_t fragmentationPermille; // 1000 * (1 - largestFreeBlock / freeBytes).
+    uint16_t stackMarginBytes; // Untouched bytes between the heap top and the deepest main-stack use.
+    uint16_t minFreeBytes; // Lowest freeBytes seen by sample() since boot.
+};
+
+/**
+ * @brief Heap and fragmentation monitor for the AVR target.
+ * Device constructors allocate with new[] and Motor grows its instance list with realloc, so
+ * both the total and the largest free block matter when adding devices. The free list is
+ * walked inside a critical section, so sample() takes a few microseconds per free block.
+ */
+namespace MemoryMonitor
+{
+    /**
+     * @brief Paints the gap between the heap top and the main stack with a canary pattern,
+     * so stackMarginBytes can report how close the two have come. ControllerRunner::run() calls it.
+     */
+    void begin();
+
+    /**
+     * @brief Takes a snapshot and updates the minimum free memory.
+     */
+    void sample(MemoryStats& stats);
+
+    /**
+     * @brief Returns the current free memory (free list plus gap).
+     */
+    uint16_t freeBytes();
+
+    /**
+     * @brief Returns the lowest free memory seen by sample() since boot.
+     */
+    uint16_t minFreeBytes();
+
+    /**
+     * @brief Prints a snapshot through DPRINT.
+     */
+    void report();
+}
+
+#endif // AHA_DEVICES_MEMORY_MONITOR_H
@@ -2,6 +2,7 @@
 // Created by Patryk Zieliński on 23/07/2024.
 //
 
+#define DEBUG_MODULE LogModule::MOTIONSENSOR
 #include "MotionSensor.h"
 
 void MotionSensor::_handleMotionDetected()
@@ -2,7 +2,14 @@
 // Created by zielq on 24.11.2024.
 //
 
+#define DEBUG_MODULE LogModule::MOTOR
 #include "Motor.h"
+#include "BootProfiler.h"
+#include "Bus/MqttBusLock.h"
+#ifdef TRACEPOINTS_MOTOR
+#define TRACEPOINTS_ENABLED
+#endif
+#include "Trace/Tracepoint.h"
 
 Motor* Motor::_findMotorByHACover(HACover* haCover)
 {
@@ -48,6 +55,7 @@ void Motor::_onCommand(HACover::CoverCommand command, HACover* sender)
 
 void Motor::setup()
 {
+    BOOT_PROFILE_SCOPE(F("Motor"), _haCover->uniqueId());
     pinMode(_motorOpenPin, OUTPUT);
     pinMode(_motorClosePin, OUTPUT);
     _motorStop();
@@ -101,6 +109,7 @@ void Motor::_motorStop()
     digitalWrite(_motorClosePin, LOW);
     _direction = DirectionNone;
     _startSafetyDelay();
+    MqttBusLock lock;
     _haCover->setState(HACover::CoverState::StateStopped);
 }
 
@@ -109,6 +118,7 @@ void Motor::_stateIdle()
     if (_currentPositionMs != _targetPositionMs)
     {
         _state = StateTargetingPosition;
+        TRACE_EVENT(TP_MOTOR_STATE, _state);
         DPRINTLN(F("[Cover] #_stateIdle() -> StateTargetingPosition"));
     }
 }
@@ -134,6 +144,7 @@ void Motor::_stateTargetingPosition()
         else if (_currentPositionMs == _targetPositionMs)
         {
             _state = StateIdle;
+            TRACE_EVENT(TP_MOTOR_STATE, _state);
             DPRINTLN(F("[Motor] #_stateTargetingPosition() -> _state=StateIdle"));
         }
 
@@ -165,6 +176,7 @@ void Motor::_stateTargetingPosition()
             _motorStop();
             DPRINTLN(F("[Motor] #_stateTargeting() direction open -> _motorStop()"));
             _state = StateIdle;
+            TRACE_EVENT(TP_MOTOR_STATE, _state);
         }
     }
 
@@ -192,6 +204,7 @@ void Motor::_stateTargetingPosition()
             _motorStop();
             DPRINTLN(F("[Motor] #_stateTargeting() direction close -> _motorStop()"));
             _state = StateIdle;
+            TRACE_EVENT(TP_MOTOR_STATE, _state);
         }
     }
 }
@@ -219,9 +232,35 @@ void Motor::stop()
     _targetPositionMs = _currentPositionMs;
     _motorStop();
     _state = StateIdle;
+    TRACE_EVENT(TP_MOTOR_STATE, _state);
 }
 
 bool Motor::isTargeting() const
 {
     return _state == StateTargetingPosition;
 }
+
+bool Motor::isAnyTargeting()
+{
+    for (uint8_t i = 0; i < _instanceIndexCounter; i++)
+    {
+        if (_instances[i]->isTargeting())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Motor::safeStopAll()
+{
+    for (uint8_t i = 0; i < _instanceIndexCounter; i++)
+    {
+        Motor* motor = _instances[i];
+        digitalWrite(motor->_motorOpenPin, LOW);
+        digitalWrite(motor->_motorClosePin, LOW);
+        motor->_direction = DirectionNone;
+        motor->_targetPositionMs = motor->_currentPositionMs;
+        motor->_state = StateIdle;
+    }
+}
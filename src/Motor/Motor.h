@@ -88,6 +88,11 @@ public:
     void stop();
 
     bool isTargeting() const;
+
+    static bool isAnyTargeting();
+
+    // Emergency stop for all motors without HA traffic, usable as a ControllerRunner safe-state hook.
+    static void safeStopAll();
 };
 
 
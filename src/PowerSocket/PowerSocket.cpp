@@ -1,7 +1,11 @@
 // Filename: PowerSocket.cpp
 // Version: Refactored with Linked List, Two-Phase Init, and Memory Safety
 
+#define DEBUG_MODULE LogModule::POWERSOCKET
 #include "PowerSocket.h"
+#include "BootProfiler.h"
+#include "Bus/MqttBusLock.h"
+#include "LatencyTrace.h"
 
 // Initialization of the static head pointer for the linked list
 PowerSocket* PowerSocket::_head = nullptr;
@@ -93,6 +97,7 @@ void PowerSocket::setup()
 {
     for (PowerSocket* current = _head; current != nullptr; current = current->_nextInstance)
     {
+        BOOT_PROFILE_SCOPE(F("PowerSocket"), current->_haSwitch->uniqueId());
         current->_setup();
     }
 }
@@ -153,10 +158,12 @@ void PowerSocket::setState(bool state)
     DPRINTLN(F(")"));
 
     digitalWrite(_switchPin, state ? _switchedOnPinState : !_switchedOnPinState);
+    LATENCY_TRACE_ACTUATED();
     _state = state;
 
     if (_haSwitch)
     {
+        MqttBusLock lock;
         _haSwitch->setState(state, true); // Report state back to HA
     }
 }
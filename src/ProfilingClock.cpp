@@ -0,0 +1,44 @@
+#include "ProfilingClock.h"
+
+#ifdef PROFILINGCLOCK
+
+// High word of the cycle count, incremented on every Timer5 overflow.
+static volatile uint16_t s_overflows = 0;
+
+ISR(TIMER5_OVF_vect)
+{
+    s_overflows++;
+}
+
+void ProfilingClock::begin()
+{
+    uint8_t sreg = SREG;
+    cli();
+    TCCR5A = 0; // Normal mode, counts 0..0xFFFF.
+    TCCR5B = _BV(CS50); // Clock source: CPU clock, no prescaler.
+    TCNT5 = 0;
+    TIFR5 = _BV(TOV5); // Clear a stale overflow flag.
+    TIMSK5 = _BV(TOIE5);
+    s_overflows = 0;
+    SREG = sreg;
+}
+
+uint32_t ProfilingClock::now()
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t low = TCNT5;
+    uint16_t high = s_overflows;
+
+    // An overflow that happened after interrupts were disabled is still pending: account for
+    // it if the low word was read after the wrap.
+    if ((TIFR5 & _BV(TOV5)) && low < 0x8000)
+    {
+        high++;
+    }
+    SREG = sreg;
+
+    return ((uint32_t)high << 16) | low;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef AHA_DEVICES_PROFILING_CLOCK_H
+#define AHA_DEVICES_PROFILING_CLOCK_H
+
+#include <Arduino.h>
+#include <Debug.h>
+
+#ifdef PROFILINGCLOCK
+
+/**
+ * @brief Cycle-accurate clock for profiling, enabled with PROFILINGCLOCK in Debug.h.
+ * Timer5 runs free at the CPU clock (prescaler 1, 62.5 ns at 16 MHz) and its overflow
+ * interrupt (every 4.1 ms) extends the count to 32 bits, which wraps after 268 s.
+ * Timer5 must not be used by anything else (e.g. the Servo library on pins 44-46).
+ * TaskMonitor and the ControllerRunner task statistics measure with this clock when it is
+ * enabled and keep cycles, see PROFILE_SCOPE in TaskMonitor.h.
+ */
+namespace ProfilingClock
+{
+    /**
+     * @brief Starts Timer5. ControllerRunner::run() calls it.
+     */
+    void begin();
+
+    /**
+     * @brief Returns the 32-bit cycle count. Safe from tasks and ISRs.
+     */
+    uint32_t now();
+
+    /**
+     * @brief Converts a cycle difference to microseconds.
+     */
+    inline uint32_t cyclesToUs(uint32_t cycles)
+    {
+        return cycles / (F_CPU / 1000000UL);
+    }
+
+    /**
+     * @brief Converts a cycle difference to nanoseconds, saturating at 4.29 s.
+     */
+    inline uint32_t cyclesToNs(uint32_t cycles)
+    {
+        uint64_t ns = (uint64_t)cycles * 1000 / (F_CPU / 1000000UL);
+        return ns > 0xFFFFFFFFUL ? 0xFFFFFFFFUL : (uint32_t)ns;
+    }
+
+    /**
+     * @brief Returns the microseconds elapsed since a now() value, wrap-around safe.
+     */
+    inline uint32_t elapsedUs(uint32_t startCycles)
+    {
+        return cyclesToUs(now() - startCycles);
+    }
+}
+
+#endif
+
+#endif // AHA_DEVICES_PROFILING_CLOCK_H
@@ -0,0 +1,191 @@
+#define DEBUG_MODULE LogModule::DIAGNOSTICS
+#include "TaskDiagnostics.h"
+
+#ifdef TASKDIAGNOSTICS
+
+#include "ControllerRunner.h"
+#include "MemoryMonitor.h"
+#include "Bus/MqttBusLock.h"
+
+TaskDiagnostics* TaskDiagnostics::_head = nullptr;
+
+TaskDiagnostics::TaskDiagnostics(
+    uint8_t taskIndex,
+    const __FlashStringHelper* name,
+    HASensorNumber* executionUs,
+    HASensorNumber* p99Us,
+    HASensorNumber* stackFree,
+    HASensorNumber* deadlineMisses,
+    HASensorNumber* p50Us,
+    HASensorNumber* p95Us
+) : _taskIndex(taskIndex),
+    _executionUs(executionUs),
+    _p99Us(p99Us),
+    _stackFree(stackFree),
+    _deadlineMisses(deadlineMisses),
+    _p50Us(p50Us),
+    _p95Us(p95Us),
+    _lastIterations(0),
+    _lastTotalUs(0),
+    _names{},
+    _nextInstance(nullptr)
+{
+    char* buffer = nullptr;
+    if (name)
+    {
+        buffer = new char[strlen_P(reinterpret_cast<const char*>(name)) + 1];
+        strcpy_P(buffer, reinterpret_cast<const char*>(name));
+    }
+    _initialize(buffer);
+    delete[] buffer;
+}
+
+TaskDiagnostics::TaskDiagnostics(
+    uint8_t taskIndex,
+    const char* name,
+    HASensorNumber* executionUs,
+    HASensorNumber* p99Us,
+    HASensorNumber* stackFree,
+    HASensorNumber* deadlineMisses,
+    HASensorNumber* p50Us,
+    HASensorNumber* p95Us
+) : _taskIndex(taskIndex),
+    _executionUs(executionUs),
+    _p99Us(p99Us),
+    _stackFree(stackFree),
+    _deadlineMisses(deadlineMisses),
+    _p50Us(p50Us),
+    _p95Us(p95Us),
+    _lastIterations(0),
+    _lastTotalUs(0),
+    _names{},
+    _nextInstance(nullptr)
+{
+    _initialize(name);
+}
+
+TaskDiagnostics::~TaskDiagnostics()
+{
+    for (char* name : _names)
+    {
+        delete[] name;
+    }
+}
+
+void TaskDiagnostics::_initialize(const char* name)
+{
+    _setName(0, _executionUs, name, F(" exec time"));
+    _setName(1, _p99Us, name, F(" exec p99"));
+    _setName(2, _stackFree, name, F(" stack free"));
+    _setName(3, _deadlineMisses, name, F(" deadline misses"));
+    _setName(4, _p50Us, name, F(" exec p50"));
+    _setName(5, _p95Us, name, F(" exec p95"));
+
+    if (_executionUs) _executionUs->setUnitOfMeasurement("us");
+    if (_p50Us) _p50Us->setUnitOfMeasurement("us");
+    if (_p95Us) _p95Us->setUnitOfMeasurement("us");
+    if (_p99Us) _p99Us->setUnitOfMeasurement("us");
+    if (_stackFree) _stackFree->setUnitOfMeasurement("B");
+
+    _nextInstance = _head;
+    _head = this;
+}
+
+void TaskDiagnostics::_setName(uint8_t slot, HASensorNumber* sensor, const char* name, const __FlashStringHelper* suffix)
+{
+    if (sensor == nullptr || name == nullptr)
+    {
+        return;
+    }
+
+    size_t nameLen = strlen(name);
+    _names[slot] = new char[nameLen + strlen_P(reinterpret_cast<const char*>(suffix)) + 1];
+    strcpy(_names[slot], name);
+    strcpy_P(_names[slot] + nameLen, reinterpret_cast<const char*>(suffix));
+    sensor->setName(_names[slot]);
+}
+
+void TaskDiagnostics::setFreeHeapSensor(HASensorNumber* freeHeap, HASensorNumber* largestBlock, HASensorNumber* minFreeHeap)
+{
+    _freeHeap = freeHeap;
+    _largestBlock = largestBlock;
+    _minFreeHeap = minFreeHeap;
+    if (_freeHeap) _freeHeap->setUnitOfMeasurement("B");
+    if (_largestBlock) _largestBlock->setUnitOfMeasurement("B");
+    if (_minFreeHeap) _minFreeHeap->setUnitOfMeasurement("B");
+}
+
+void TaskDiagnostics::setPublishInterval(uint32_t intervalMs)
+{
+    _publishIntervalMs = intervalMs;
+}
+
+void TaskDiagnostics::loop()
+{
+    uint32_t now = millis();
+    if (_publishedOnce && now - _lastPublishMs < _publishIntervalMs)
+    {
+        return;
+    }
+    _lastPublishMs = now;
+    _publishedOnce = true;
+
+    MqttBusLock lock;
+
+    for (TaskDiagnostics* current = _head; current != nullptr; current = current->_nextInstance)
+    {
+        current->_publish();
+    }
+
+    if (_freeHeap || _largestBlock || _minFreeHeap)
+    {
+        MemoryStats memory;
+        MemoryMonitor::sample(memory);
+        if (_freeHeap) _freeHeap->setValue((uint32_t)memory.freeBytes);
+        if (_largestBlock) _largestBlock->setValue((uint32_t)memory.largestFreeBlock);
+        if (_minFreeHeap) _minFreeHeap->setValue((uint32_t)memory.minFreeBytes);
+    }
+}
+
+void TaskDiagnostics::_publish()
+{
+    TaskStats stats;
+    if (!ControllerRunner::getTaskStats(_taskIndex, stats))
+    {
+        return;
+    }
+
+    if (_executionUs)
+    {
+        uint32_t iterations = stats.iterations - _lastIterations;
+        uint32_t totalUs = stats.totalExecutionUs - _lastTotalUs;
+        _executionUs->setValue(iterations > 0 ? totalUs / iterations : (uint32_t)0);
+    }
+    _lastIterations = stats.iterations;
+    _lastTotalUs = stats.totalExecutionUs;
+
+    if (_deadlineMisses)
+    {
+        _deadlineMisses->setValue((uint32_t)stats.deadlineMisses);
+    }
+
+    if (_stackFree)
+    {
+        TaskHandle_t handle = ControllerRunner::getTaskHandle(_taskIndex);
+        if (handle != NULL)
+        {
+            _stackFree->setValue((uint32_t)(uxTaskGetStackHighWaterMark(handle) * sizeof(StackType_t)));
+        }
+    }
+
+    // Updated by the task's monitor once per its log interval. Nanoseconds in the stats,
+    // the sensor's precision decides the published digits.
+    if (ControllerRunner::getTaskMonitor(_taskIndex) != nullptr)
+    {
+        if (_p50Us) _p50Us->setValue(stats.p50ExecutionNs / 1000.0f);
+        if (_p95Us) _p95Us->setValue(stats.p95ExecutionNs / 1000.0f);
+        if (_p99Us) _p99Us->setValue(stats.p99ExecutionNs / 1000.0f);
+    }
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef AHA_DEVICES_TASK_DIAGNOSTICS_H
+#define AHA_DEVICES_TASK_DIAGNOSTICS_H
+
+#include "Debug.h"
+
+#ifdef TASKDIAGNOSTICS
+
+#include <Arduino.h>
+#include <ArduinoHA.h>
+
+/**
+ * @class TaskDiagnostics
+ * @brief Publishes the timing and stack statistics of one ControllerRunner task as Home
+ * Assistant sensors, for release builds (enable TASKDIAGNOSTICS in Debug.h).
+ * Execution time and deadline misses come from ControllerRunner::getTaskStats(); the
+ * p50/p95/p99 sensors need a TaskMonitor in the task's TaskConfig. Any sensor may be nullptr.
+ * All instances are published together by TaskDiagnostics::loop() at a low rate.
+ */
+class TaskDiagnostics
+{
+public:
+    /**
+     * @brief Constructor for using PROGMEM (Flash) strings via F() macro.
+     * @param taskIndex Index of the task in the table passed to ControllerRunner::run().
+     * @param name Prefix of the sensor names in Home Assistant (use F() macro), e.g. F("Buttons").
+     * @param executionUs Average loopFunc time (us) over the publish interval.
+     * @param p99Us 99th percentile of loopFunc time (us) from the task's TaskMonitor.
+     * @param stackFree Stack high-water mark (free bytes).
+     * @param deadlineMisses Deadline misses since boot.
+     * @param p50Us Median loopFunc time (us) from the task's TaskMonitor.
+     * @param p95Us 95th percentile of loopFunc time (us) from the task's TaskMonitor.
+     */
+    TaskDiagnostics(
+        uint8_t taskIndex,
+        const __FlashStringHelper* name,
+        HASensorNumber* executionUs,
+        HASensorNumber* p99Us,
+        HASensorNumber* stackFree,
+        HASensorNumber* deadlineMisses,
+        HASensorNumber* p50Us = nullptr,
+        HASensorNumber* p95Us = nullptr
+    );
+
+    /**
+     * @brief Overloaded constructor for using standard C-strings from SRAM.
+     */
+    TaskDiagnostics(
+        uint8_t taskIndex,
+        const char* name,
+        HASensorNumber* executionUs,
+        HASensorNumber* p99Us,
+        HASensorNumber* stackFree,
+        HASensorNumber* deadlineMisses,
+        HASensorNumber* p50Us = nullptr,
+        HASensorNumber* p95Us = nullptr
+    );
+
+    virtual ~TaskDiagnostics();
+
+    /**
+     * @brief Sets the heap sensors (bytes, see MemoryMonitor), shared by all tasks. Any may be nullptr.
+     * @param freeHeap Current free heap.
+     * @param largestBlock Largest free block, i.e. the largest allocation that still succeeds.
+     * @param minFreeHeap Lowest free heap seen since boot.
+     */
+    static void setFreeHeapSensor(
+        HASensorNumber* freeHeap,
+        HASensorNumber* largestBlock = nullptr,
+        HASensorNumber* minFreeHeap = nullptr
+    );
+
+    /**
+     * @brief Sets how often loop() publishes, default 60 s.
+     */
+    static void setPublishInterval(uint32_t intervalMs);
+
+    /**
+     * @brief Publishes all sensors once the publish interval has elapsed.
+     * Call it from the task that runs HAMqtt::loop().
+     */
+    static void loop();
+
+private:
+    uint8_t _taskIndex;
+    HASensorNumber* _executionUs;
+    HASensorNumber* _p99Us;
+    HASensorNumber* _stackFree;
+    HASensorNumber* _deadlineMisses;
+    HASensorNumber* _p50Us;
+    HASensorNumber* _p95Us;
+
+    // Runner counters at the previous publish, for the windowed average.
+    uint32_t _lastIterations;
+    uint32_t _lastTotalUs;
+
+    // Persistent heap-allocated sensor names, one per sensor.
+    char* _names[6];
+
+    void _initialize(const char* name);
+    void _setName(uint8_t slot, HASensorNumber* sensor, const char* name, const __FlashStringHelper* suffix);
+    void _publish();
+
+    inline static HASensorNumber* _freeHeap = nullptr;
+    inline static HASensorNumber* _largestBlock = nullptr;
+    inline static HASensorNumber* _minFreeHeap = nullptr;
+    inline static uint32_t _publishIntervalMs = 60000;
+    inline static uint32_t _lastPublishMs = 0;
+    inline static bool _publishedOnce = false;
+
+    // --- Linked List for Instance Management ---
+    TaskDiagnostics* _nextInstance;
+    static TaskDiagnostics* _head;
+};
+
+#endif
+
+#endif //AHA_DEVICES_TASK_DIAGNOSTICS_H
@@ -3,54 +3,81 @@
 
 #include "Debug.h" // This file controls the DEBUG macro
 
-#ifdef DEBUGSTACK // Only compile this entire class if DEBUG is enabled
-
-#include <Arduino.h>
-#include <Arduino_FreeRTOS.h>
-#include <semphr.h>
-
-// External declaration of the semaphore handle.
-// It tells the compiler that this variable exists and will be defined elsewhere.
-extern SemaphoreHandle_t g_serialSemaphore;
+#ifdef DEBUGSTACK
+#include "DeferredLog.h"
 
 /**
- * @brief A smart, thread-safe macro for printing debug information.
- * It automatically detects if the RTOS scheduler is running.
- * - If called from setup(), it prints directly to Serial.
- * - If called from a task, it uses a mutex semaphore for thread safety.
+ * @brief Thread-safe debug printing that does not block the calling task.
+ * Each call is queued as one record and written to Serial later by the DeferredLog
+ * drain task (or printed directly while the scheduler is not running yet).
+ * Strings are kept by pointer: pass F() strings or SRAM strings that stay valid.
  */
-#define SDPRINT(...) do { \
-if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) { \
-/* RTOS scheduler is running, use semaphore for thread safety */ \
-if (g_serialSemaphore != NULL && xSemaphoreTake(g_serialSemaphore, pdMS_TO_TICKS(10)) == pdTRUE) { \
-Serial.print(__VA_ARGS__); \
-xSemaphoreGive(g_serialSemaphore); \
-} \
-} else { \
-/* RTOS not started (we are in setup()), print directly */ \
-Serial.print(__VA_ARGS__); \
-} \
-} while(0)
-
-#define SDPRINTLN(...) do { \
-if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) { \
-/* RTOS scheduler is running, use semaphore */ \
-if (g_serialSemaphore != NULL && xSemaphoreTake(g_serialSemaphore, pdMS_TO_TICKS(10)) == pdTRUE) { \
-Serial.println(__VA_ARGS__); \
-xSemaphoreGive(g_serialSemaphore); \
-} \
-} else { \
-/* RTOS not started, print directly */ \
-Serial.println(__VA_ARGS__); \
-} \
-} while(0)
+#define SDPRINT(...) DeferredLog::print(__VA_ARGS__)
+#define SDPRINTLN(...) DeferredLog::println(__VA_ARGS__)
+#else
+// Without DEBUGSTACK, macros are empty - zero overhead.
+#define SDPRINT(...)
+#define SDPRINTLN(...)
+#endif
 
+#ifdef TASKMONITOR // Only compile the class if DEBUGSTACK or TASKDIAGNOSTICS is enabled
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include "LatencyHistogram.h"
+#include "MemoryMonitor.h"
+#include "ProfilingClock.h"
+
+// Log2 buckets of the TaskMonitor histogram. It counts ProfilingClock cycles when enabled,
+// 24 buckets reach 0.5..1 s at 16 MHz; micros() otherwise, like LatencyHistogram.
+#ifndef TASK_MONITOR_HISTOGRAM_BUCKETS
+#ifdef PROFILINGCLOCK
+#define TASK_MONITOR_HISTOGRAM_BUCKETS 24
+#else
+#define TASK_MONITOR_HISTOGRAM_BUCKETS LATENCY_HISTOGRAM_BUCKETS
+#endif
+#endif
 
 /**
  * @class TaskMonitor
  * @brief A helper class to measure and log execution stats and stack usage for an RTOS task.
+ * Without a task handle it can also time a named code section, see TaskMonitor::Section.
+ * Durations are kept in clock ticks (ProfilingClock cycles with PROFILINGCLOCK, microseconds
+ * otherwise) and only converted to nanoseconds for the summary.
  */
 class TaskMonitor {
+public:
+    /**
+     * @struct Summary
+     * @brief Statistics of the last completed report interval.
+     */
+    struct Summary {
+        unsigned long executions;
+        uint32_t minNs; // Durations in nanoseconds, saturating at 4.29 s.
+        uint32_t avgNs;
+        uint32_t maxNs;
+        uint32_t p50Ns;
+        uint32_t p95Ns;
+        uint32_t p99Ns;
+        uint16_t stackFreeBytes; // 0 without a task handle.
+    };
+
+    /**
+     * @class Section
+     * @brief Times the enclosing block with a monitor and reports when its interval is due.
+     */
+    class Section {
+    public:
+        explicit Section(TaskMonitor& monitor) : _monitor(monitor) { _monitor.beginMeasurement(); }
+        ~Section() {
+            _monitor.endMeasurement();
+            _monitor.report();
+        }
+
+    private:
+        TaskMonitor& _monitor;
+    };
+
 private:
     // --- Configuration ---
     const char* _name;
@@ -59,12 +86,14 @@ private:
 
     // --- Statistics for the measurement interval ---
     unsigned long _executionCount;
-    unsigned long _totalExecutionTime_us;
-    unsigned long _minExecutionTime_us;
-    unsigned long _maxExecutionTime_us;
+    unsigned long _totalExecutionTicks;
+    unsigned long _minExecutionTicks;
+    unsigned long _maxExecutionTicks;
+    BasicLatencyHistogram<TASK_MONITOR_HISTOGRAM_BUCKETS> _histogram;
+    Summary _lastSummary{};
     
     // --- Internal state ---
-    unsigned long _startTime_us;
+    uint32_t _startTime; // ProfilingClock cycles with PROFILINGCLOCK, micros() otherwise.
     unsigned long _lastLogTime_ms;
 
 public:
@@ -73,10 +102,10 @@ public:
           _taskHandle(taskHandle),
           _logInterval_ms(logInterval),
           _executionCount(0),
-          _totalExecutionTime_us(0),
-          _minExecutionTime_us(0xFFFFFFFF),
-          _maxExecutionTime_us(0),
-          _startTime_us(0),
+          _totalExecutionTicks(0),
+          _minExecutionTicks(0xFFFFFFFF),
+          _maxExecutionTicks(0),
+          _startTime(0),
           _lastLogTime_ms(0)
     {}
 
@@ -85,53 +114,126 @@ public:
     }
 
     void beginMeasurement() {
-        _startTime_us = micros();
+#ifdef PROFILINGCLOCK
+        _startTime = ProfilingClock::now();
+#else
+        _startTime = micros();
+#endif
     }
 
     void endMeasurement() {
-        unsigned long duration = micros() - _startTime_us;
-        _totalExecutionTime_us += duration;
+#ifdef PROFILINGCLOCK
+        record(ProfilingClock::now() - _startTime);
+#else
+        record(micros() - _startTime);
+#endif
+    }
+
+    /**
+     * @brief Adds one externally measured duration to the statistics.
+     * @param ticks ProfilingClock cycles with PROFILINGCLOCK, microseconds otherwise.
+     */
+    void record(unsigned long ticks) {
+        _totalExecutionTicks += ticks;
         _executionCount++;
-        if (duration < _minExecutionTime_us) _minExecutionTime_us = duration;
-        if (duration > _maxExecutionTime_us) _maxExecutionTime_us = duration;
+        if (ticks < _minExecutionTicks) _minExecutionTicks = ticks;
+        if (ticks > _maxExecutionTicks) _maxExecutionTicks = ticks;
+        _histogram.record(ticks);
+    }
+
+    /**
+     * @brief Converts clock ticks to nanoseconds, saturating at 4.29 s.
+     */
+    static uint32_t ticksToNs(unsigned long ticks) {
+#ifdef PROFILINGCLOCK
+        return ProfilingClock::cyclesToNs(ticks);
+#else
+        return ticks > 0xFFFFFFFFUL / 1000 ? 0xFFFFFFFFUL : ticks * 1000;
+#endif
+    }
+
+    const char* getName() const {
+        return _name;
+    }
+
+    /**
+     * @brief Returns a copy of the statistics of the last completed report interval.
+     * Safe from other tasks: report() replaces the summary inside a critical section.
+     */
+    Summary lastSummary() const {
+        taskENTER_CRITICAL();
+        Summary summary = _lastSummary;
+        taskEXIT_CRITICAL();
+        return summary;
     }
 
     void report() {
         if (millis() - _lastLogTime_ms >= _logInterval_ms) {
             _lastLogTime_ms = millis();
             
-            unsigned long avg = (_executionCount > 0) ? (_totalExecutionTime_us / _executionCount) : 0;
+            unsigned long avg = (_executionCount > 0) ? (_totalExecutionTicks / _executionCount) : 0;
+
+            Summary summary;
+            summary.executions = _executionCount;
+            summary.minNs = _executionCount > 0 ? ticksToNs(_minExecutionTicks) : 0;
+            summary.avgNs = ticksToNs(avg);
+            summary.maxNs = ticksToNs(_maxExecutionTicks);
+            summary.p50Ns = ticksToNs(_histogram.p50());
+            summary.p95Ns = ticksToNs(_histogram.p95());
+            summary.p99Ns = ticksToNs(_histogram.p99());
+            summary.stackFreeBytes = _taskHandle != NULL ?
+                uxTaskGetStackHighWaterMark(_taskHandle) * sizeof(StackType_t) : 0;
+
+            // Read by other tasks through lastSummary().
+            taskENTER_CRITICAL();
+            _lastSummary = summary;
+            taskEXIT_CRITICAL();
             
-            // --- CORRECTED LOGGING ---
-            // Now using our thread-safe DPRINT/DPRINTLN macros.
-            // No need for manual semaphore handling here.
+            // Queued through DeferredLog, so reporting does not stall this task (no-op without DEBUGSTACK).
             SDPRINTLN(F("--- Task Performance Report ---"));
-            SDPRINT(F(" Name: ")); DPRINTLN(_name);
-            SDPRINT(F(" Executions in interval: ")); DPRINTLN(_executionCount);
-            SDPRINT(F(" Time (us)  Min/Avg/Max: "));
-            SDPRINT(_minExecutionTime_us); DPRINT(F("/"));
-            SDPRINT(avg); DPRINT(F("/"));
-            SDPRINTLN(_maxExecutionTime_us);
+            SDPRINT(F(" Name: ")); SDPRINTLN(_name);
+            SDPRINT(F(" Executions in interval: ")); SDPRINTLN(_executionCount);
+            SDPRINT(F(" Time (ns)  Min/Avg/Max: "));
+            SDPRINT(summary.minNs); SDPRINT(F("/"));
+            SDPRINT(summary.avgNs); SDPRINT(F("/"));
+            SDPRINTLN(summary.maxNs);
+            SDPRINT(F(" Time (ns)  p50/p95/p99: "));
+            SDPRINT(summary.p50Ns); SDPRINT(F("/"));
+            SDPRINT(summary.p95Ns); SDPRINT(F("/"));
+            SDPRINTLN(summary.p99Ns);
             
             if (_taskHandle != NULL) {
-                UBaseType_t hwm = uxTaskGetStackHighWaterMark(_taskHandle);
-                SDPRINT(F(" Stack HWM (free bytes): ")); DPRINTLN(hwm * sizeof(StackType_t));
+                SDPRINT(F(" Stack HWM (free bytes): ")); SDPRINTLN((unsigned int)summary.stackFreeBytes);
             }
+
+            // Sampling also keeps MemoryMonitor's minimum up to date in release builds.
+            MemoryStats memory;
+            MemoryMonitor::sample(memory);
+            SDPRINT(F(" Heap free/largest/min: "));
+            SDPRINT(memory.freeBytes); SDPRINT(F("/"));
+            SDPRINT(memory.largestFreeBlock); SDPRINT(F("/"));
+            SDPRINTLN(memory.minFreeBytes);
             SDPRINTLN(F("-------------------------------"));
 
             // Reset stats for the next interval
             _executionCount = 0;
-            _totalExecutionTime_us = 0;
-            _minExecutionTime_us = 0xFFFFFFFF;
-            _maxExecutionTime_us = 0;
+            _totalExecutionTicks = 0;
+            _minExecutionTicks = 0xFFFFFFFF;
+            _maxExecutionTicks = 0;
+            _histogram.reset();
         }
     }
 };
 
+/**
+ * @brief Times the enclosing block with a TaskMonitor, e.g. a hot path inside a loopFunc:
+ *   static TaskMonitor buttonScan("getButtonEvent");
+ *   PROFILE_SCOPE(buttonScan);
+ * Uses ProfilingClock when PROFILINGCLOCK is enabled, micros() otherwise.
+ */
+#define PROFILE_SCOPE(monitor) TaskMonitor::Section _profileSection(monitor)
 #else
-// When DEBUG is disabled, macros are empty - zero overhead.
-#define SDPRINT(...)
-#define SDPRINTLN(...)
+#define PROFILE_SCOPE(monitor)
 #endif
 
 #endif // TASK_MONITOR_H
@@ -0,0 +1,185 @@
+#define DEBUG_MODULE LogModule::RUNNER
+#include "TaskTuner.h"
+
+#include "ControllerRunner.h"
+#include "Bus/MqttBusLock.h"
+
+// Upper bound offered in Home Assistant for PERIOD_MS entities.
+static const int32_t MAX_PERIOD_MS = 60000;
+
+TaskTuner* TaskTuner::_head = nullptr;
+
+TaskTuner::TaskTuner(
+    HANumber* haNumber,
+    uint8_t taskIndex,
+    Parameter parameter,
+    const __FlashStringHelper* name,
+    const __FlashStringHelper* icon
+) : _haNumber(haNumber),
+    _taskIndex(taskIndex),
+    _parameter(parameter),
+    _haNameBuffer(nullptr),
+    _haIconBuffer(nullptr),
+    _nextInstance(nullptr)
+{
+    _initialize(name, icon);
+}
+
+TaskTuner::TaskTuner(
+    HANumber* haNumber,
+    uint8_t taskIndex,
+    Parameter parameter,
+    const char* name,
+    const char* icon
+) : _haNumber(haNumber),
+    _taskIndex(taskIndex),
+    _parameter(parameter),
+    _haNameBuffer(nullptr),
+    _haIconBuffer(nullptr),
+    _nextInstance(nullptr)
+{
+    _initialize(name, icon);
+}
+
+TaskTuner::~TaskTuner()
+{
+    delete[] _haNameBuffer;
+    delete[] _haIconBuffer;
+}
+
+void TaskTuner::_initialize(const __FlashStringHelper* name, const __FlashStringHelper* icon)
+{
+    if (name)
+    {
+        _haNameBuffer = new char[strlen_P(reinterpret_cast<const char*>(name)) + 1];
+        strcpy_P(_haNameBuffer, reinterpret_cast<const char*>(name));
+    }
+    if (icon)
+    {
+        _haIconBuffer = new char[strlen_P(reinterpret_cast<const char*>(icon)) + 1];
+        strcpy_P(_haIconBuffer, reinterpret_cast<const char*>(icon));
+    }
+
+    _initialize(_haNameBuffer, _haIconBuffer);
+}
+
+void TaskTuner::_initialize(const char* name, const char* icon)
+{
+    if (name && _haNameBuffer == nullptr)
+    {
+        _haNameBuffer = new char[strlen(name) + 1];
+        strcpy(_haNameBuffer, name);
+    }
+    if (icon && _haIconBuffer == nullptr)
+    {
+        _haIconBuffer = new char[strlen(icon) + 1];
+        strcpy(_haIconBuffer, icon);
+    }
+
+    _haNumber->setName(_haNameBuffer);
+    if (icon)
+    {
+        _haNumber->setIcon(_haIconBuffer);
+    }
+    _haNumber->setMode(HANumber::ModeBox);
+
+    if (_parameter == PERIOD_MS)
+    {
+        _haNumber->setMin(portTICK_PERIOD_MS);
+        _haNumber->setMax(MAX_PERIOD_MS);
+        _haNumber->setStep(portTICK_PERIOD_MS);
+    }
+    else
+    {
+        _haNumber->setMin(0);
+        _haNumber->setMax(configMAX_PRIORITIES - 1);
+        _haNumber->setStep(1);
+    }
+
+    _nextInstance = _head;
+    _head = this;
+}
+
+void TaskTuner::setup()
+{
+    DPRINTLN(F("Setting up all TaskTuner instances..."));
+    for (TaskTuner* current = _head; current != nullptr; current = current->_nextInstance)
+    {
+        current->_setup();
+    }
+}
+
+void TaskTuner::_setup()
+{
+    _haNumber->setCurrentState(_currentValue());
+    _haNumber->onCommand(TaskTuner::onCommand);
+}
+
+int32_t TaskTuner::_currentValue() const
+{
+    if (_parameter == PRIORITY)
+    {
+        return ControllerRunner::getTaskPriority(_taskIndex);
+    }
+
+    // Kept within the number's range: a task without timeout (portMAX_DELAY, it only runs
+    // when notified) or with a longer configured period shows as the longest period.
+    TickType_t ticks = ControllerRunner::getTaskPeriod(_taskIndex);
+    if (ticks == portMAX_DELAY || (int32_t)ticks * portTICK_PERIOD_MS > MAX_PERIOD_MS)
+    {
+        return MAX_PERIOD_MS;
+    }
+    return (int32_t)ticks * portTICK_PERIOD_MS;
+}
+
+void TaskTuner::_apply(int32_t value)
+{
+    if (_parameter == PRIORITY)
+    {
+        if (value >= 0)
+        {
+            ControllerRunner::setTaskPriority(_taskIndex, (UBaseType_t)value);
+        }
+    }
+    else if (value > 0 && value <= MAX_PERIOD_MS)
+    {
+        // Round to whole ticks; periods shorter than one tick run every tick.
+        TickType_t ticks = (value + portTICK_PERIOD_MS / 2) / portTICK_PERIOD_MS;
+        ControllerRunner::setTaskPeriod(_taskIndex, ticks > 0 ? ticks : 1);
+    }
+
+    DPRINT(F("[TaskTuner] Task "));
+    DPRINT(_taskIndex);
+    DPRINT(F(" = "));
+    DPRINTLN(_currentValue());
+
+    // Report what is actually in effect after rounding and validation. Commands arrive in the
+    // MqttBus task, which already holds the (recursive) lock.
+    MqttBusLock lock;
+    _haNumber->setState(_currentValue(), true);
+}
+
+TaskTuner* TaskTuner::findInstance(HANumber* haNumber)
+{
+    for (TaskTuner* current = _head; current != nullptr; current = current->_nextInstance)
+    {
+        if (current->_haNumber == haNumber)
+        {
+            return current;
+        }
+    }
+    return nullptr;
+}
+
+void TaskTuner::onCommand(HANumeric number, HANumber* sender)
+{
+    if (!number.isSet())
+    {
+        return;
+    }
+
+    if (TaskTuner* tuner = findInstance(sender); tuner != nullptr)
+    {
+        tuner->_apply(number.toInt32());
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef AHA_DEVICES_TASK_TUNER_H
+#define AHA_DEVICES_TASK_TUNER_H
+
+#include <Arduino.h>
+#include <ArduinoHA.h>
+
+#include "Debug.h"
+
+/**
+ * @class TaskTuner
+ * @brief Exposes the period or priority of one ControllerRunner task as a Home Assistant number,
+ * so a task rate can be tuned live while watching its TaskMonitor statistics.
+ * Values are applied through ControllerRunner::setTaskPeriod() / setTaskPriority() and are
+ * therefore persisted when ControllerRunner::enableTuningPersistence() is enabled.
+ */
+class TaskTuner
+{
+public:
+    /**
+     * @enum Parameter
+     * @brief The task property controlled by the number entity.
+     */
+    enum Parameter
+    {
+        PERIOD_MS, // TaskConfig::delayTicks, in milliseconds (rounded to whole ticks).
+        PRIORITY // FreeRTOS priority of the task (of its group for grouped entries).
+    };
+
+    /**
+     * @brief Constructor for using PROGMEM (Flash) strings via F() macro.
+     * @param haNumber The HANumber entity from the ArduinoHA library.
+     * @param taskIndex Index of the task in the table passed to ControllerRunner::run().
+     * @param parameter The task property to control.
+     * @param name The name of the entity for Home Assistant (use F() macro).
+     * @param icon Optional: The icon for Home Assistant (use F() macro).
+     */
+    TaskTuner(
+        HANumber* haNumber,
+        uint8_t taskIndex,
+        Parameter parameter,
+        const __FlashStringHelper* name = nullptr,
+        const __FlashStringHelper* icon = nullptr
+    );
+
+    /**
+     * @brief Overloaded constructor for using standard C-strings from SRAM.
+     * @param haNumber The HANumber entity from the ArduinoHA library.
+     * @param taskIndex Index of the task in the table passed to ControllerRunner::run().
+     * @param parameter The task property to control.
+     * @param name The name of the entity for Home Assistant.
+     * @param icon Optional: The icon for Home Assistant.
+     */
+    TaskTuner(
+        HANumber* haNumber,
+        uint8_t taskIndex,
+        Parameter parameter,
+        const char* name,
+        const char* icon = nullptr
+    );
+
+    /**
+     * @brief Destructor to free dynamically allocated memory for name and icon.
+     */
+    virtual ~TaskTuner();
+
+    /**
+     * @brief Registers the callbacks and loads the current values of all instances.
+     * Call from a task's setupFunc, i.e. after ControllerRunner::run() created the tasks.
+     */
+    static void setup();
+
+private:
+    HANumber* _haNumber;
+    uint8_t _taskIndex;
+    Parameter _parameter;
+
+    // Buffers to hold the persistent heap-allocated copies of name and icon
+    char* _haNameBuffer;
+    char* _haIconBuffer;
+
+    void _initialize(const __FlashStringHelper* name, const __FlashStringHelper* icon);
+    void _initialize(const char* name, const char* icon);
+    void _setup();
+
+    /**
+     * @brief Applies a value received from Home Assistant and reports the value in effect.
+     */
+    void _apply(int32_t value);
+
+    /**
+     * @brief Returns the current value of the controlled property in entity units.
+     */
+    int32_t _currentValue() const;
+
+    // --- Linked List for Instance Management ---
+    TaskTuner* _nextInstance;
+    static TaskTuner* _head;
+
+    // --- Static callback handling ---
+    static TaskTuner* findInstance(HANumber* haNumber);
+    static void onCommand(HANumeric number, HANumber* sender);
+};
+
+#endif //AHA_DEVICES_TASK_TUNER_H
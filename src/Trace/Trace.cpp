@@ -0,0 +1,68 @@
+#include "Trace/Trace.h"
+
+#ifdef TRACE
+#include <Arduino_FreeRTOS.h>
+
+// Size of a record without arguments: sync, id, length and the timestamp.
+static const uint8_t HEADER_BYTES = 7;
+
+static uint16_t s_dropped = 0;
+static uint16_t s_reportedDropped = 0;
+
+/**
+ * @brief Writes a record header followed by the arguments. The caller has checked the space.
+ */
+static void write_record(TraceId id, const uint8_t* args, uint8_t length, uint32_t timestampUs)
+{
+    uint8_t header[HEADER_BYTES] = {
+        TRACE_SYNC,
+        (uint8_t)id,
+        length,
+        (uint8_t)timestampUs,
+        (uint8_t)(timestampUs >> 8),
+        (uint8_t)(timestampUs >> 16),
+        (uint8_t)(timestampUs >> 24)
+    };
+    LOG_SERIAL.write(header, HEADER_BYTES);
+    if (length > 0)
+    {
+        LOG_SERIAL.write(args, length);
+    }
+}
+
+void Trace::emit(TraceId id, const uint8_t* args, uint8_t length)
+{
+    // The whole record goes out under one critical section, so records of different tasks
+    // never interleave; Serial.write does not block because the space was checked first.
+    // The timestamp is taken inside it too, so timestamps increase in stream order.
+    taskENTER_CRITICAL();
+    uint32_t timestampUs = micros();
+    uint16_t unreported = s_dropped - s_reportedDropped;
+    int space = LOG_SERIAL.availableForWrite();
+    int needed = HEADER_BYTES + length + (unreported ? HEADER_BYTES + sizeof(uint16_t) : 0);
+
+    if (space >= needed)
+    {
+        if (unreported)
+        {
+            write_record(TraceId::TRACE_DROPPED, reinterpret_cast<const uint8_t*>(&unreported),
+                         sizeof(unreported), timestampUs);
+            s_reportedDropped = s_dropped;
+        }
+        write_record(id, args, length, timestampUs);
+    }
+    else
+    {
+        s_dropped++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+uint16_t Trace::droppedCount()
+{
+    taskENTER_CRITICAL();
+    uint16_t dropped = s_dropped;
+    taskEXIT_CRITICAL();
+    return dropped;
+}
+#endif
@@ -0,0 +1,80 @@
+#ifndef AHA_DEVICES_TRACE_H
+#define AHA_DEVICES_TRACE_H
+
+#include "Debug.h"
+
+#ifdef TRACE
+
+#include <Arduino.h>
+#include "Trace/TraceIds.h"
+
+// Maximum size of the binary arguments of one record; longer records are truncated.
+#ifndef TRACE_MAX_ARGS_BYTES
+#define TRACE_MAX_ARGS_BYTES 24
+#endif
+
+/**
+ * @brief Compact binary tracing to LOG_SERIAL (see Debug.h), decoded on the host by tools/trace_decode.py.
+ * A record is [0xA5][id][length][micros() as u32][arguments], all little-endian; arguments
+ * are written with their own size, so their types must match the {..} placeholders in
+ * TraceIds.h. Records are written only if they fit into the TX buffer, otherwise they
+ * are counted and reported later as TRACE_DROPPED, so tracing never blocks the caller.
+ * Do not combine with logging (LOG_LEVEL in Debug.h), the text output would corrupt the stream.
+ */
+namespace Trace
+{
+    /**
+     * @brief Writes one record with already packed arguments. Safe from any task.
+     */
+    void emit(TraceId id, const uint8_t* args, uint8_t length);
+
+    /**
+     * @brief Returns the number of records dropped since boot.
+     */
+    uint16_t droppedCount();
+
+    template <typename T>
+    inline void pack(uint8_t* buffer, uint8_t& length, T value)
+    {
+        if (length + sizeof(T) <= TRACE_MAX_ARGS_BYTES)
+        {
+            memcpy(buffer + length, &value, sizeof(T));
+            length += sizeof(T);
+        }
+    }
+
+    inline void pack(uint8_t* buffer, uint8_t& length, const char* value)
+    {
+        if (length >= TRACE_MAX_ARGS_BYTES)
+        {
+            return;
+        }
+
+        // Strings carry their own length byte, so a truncated one still decodes.
+        size_t size = value ? strlen(value) : 0;
+        size_t room = TRACE_MAX_ARGS_BYTES - length - 1;
+        if (size > room)
+        {
+            size = room;
+        }
+        buffer[length++] = size;
+        memcpy(buffer + length, value, size);
+        length += size;
+    }
+
+    template <typename... Args>
+    inline void log(TraceId id, Args... args)
+    {
+        uint8_t buffer[TRACE_MAX_ARGS_BYTES];
+        uint8_t length = 0;
+        (pack(buffer, length, args), ...);
+        emit(id, buffer, length);
+    }
+}
+
+#define TPRINT(id, ...) Trace::log(TraceId::id, ##__VA_ARGS__)
+#else
+#define TPRINT(id, ...)
+#endif
+
+#endif // AHA_DEVICES_TRACE_H
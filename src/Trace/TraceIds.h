@@ -0,0 +1,55 @@
+#ifndef AHA_DEVICES_TRACE_IDS_H
+#define AHA_DEVICES_TRACE_IDS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Table of all binary trace sites, see TPRINT in Trace.h.
+ * The ID of an entry is its position in this list. The format strings are never compiled
+ * into the firmware: tools/trace_decode.py reads them from this file, so keep one X(...)
+ * per line and only append, or old captures will decode with the wrong text.
+ * Tracepoints (Trace/Tracepoint.h) always carry a single {i32} value.
+ * Placeholders describe the binary arguments in order:
+ *   {u8} {u16} {u32} {i8} {i16} {i32} unsigned/signed integers of that width
+ *   {f} 32-bit float, {s} string (one length byte followed by the characters)
+ */
+#define TRACE_IDS(X) \
+    X(TRACE_DROPPED, "trace: dropped {u16} records") \
+    X(COVER_COMMAND, "[Cover {s}] command {u8}") \
+    X(COVER_TARGET, "[Cover {s}] target position {u8}% = {i32} ms") \
+    X(COVER_TARGET_TILT, "[Cover {s}] target tilt {u8}% = {i32} ms") \
+    X(COVER_MOTOR_UP, "[Cover {s}] motor up at {i32} ms") \
+    X(COVER_MOTOR_DOWN, "[Cover {s}] motor down at {i32} ms") \
+    X(COVER_MOTOR_STOP, "[Cover {s}] motor stop at {i32} ms") \
+    X(COVER_STOP, "[Cover {s}] stop, position {i32} ms saved") \
+    X(LEDSTRIP_WRITE_ERROR, "[LedStrip {s}] Modbus write error {u8}") \
+    X(LEDSTRIP_WRITE_OK, "[LedStrip {s}] configuration sent") \
+    X(DS18B20_NOT_FOUND, "[DS18B20MultiPin] sensor not found on pin {u8}") \
+    X(DS18B20_HOT_SWAP, "[DS18B20MultiPin] hot-swap: sensor found on pin {u8}") \
+    X(DS18B20_READ_ERROR, "[DS18B20MultiPin] read error on pin {u8}, count {u8}") \
+    X(DS18B20_DISCONNECTED, "[DS18B20MultiPin] sensor on pin {u8} disconnected") \
+    X(DS18B20_OUTLIER, "[DS18B20MultiPin] ignored outlier {f} on pin {u8}") \
+    X(DS18B20_UPDATED, "[DS18B20MultiPin] pin {u8} avg {f}") \
+    X(TP_COVER_STATE, "[Cover] state -> {i32}") \
+    X(TP_COVER_TARGETING, "[Cover] _stateTargetingPosition took {i32} us") \
+    X(TP_MOTOR_STATE, "[Motor] state -> {i32}") \
+    X(TP_LEDSTRIP_STATE, "[LedStrip] state -> {i32}") \
+    X(TP_LEDSTRIP_MODBUS_WRITE, "[LedStrip] _updateModbusRegisters took {i32} us") \
+    X(TP_DS18B20_STATE, "[DS18B20] state -> {i32}") \
+    X(TP_DS18B20_READ, "[DS18B20] _readAll took {i32} us") \
+    X(TP_BUTTON_EVENT, "[Button] id << 8 | event = {i32}")
+
+// First byte of every record written by Trace and Tracepoint.
+static const uint8_t TRACE_SYNC = 0xA5;
+
+#define TRACE_ID_ENUM(name, format) name,
+
+enum class TraceId : uint8_t
+{
+    TRACE_IDS(TRACE_ID_ENUM)
+    COUNT
+};
+
+#undef TRACE_ID_ENUM
+
+#endif // AHA_DEVICES_TRACE_IDS_H
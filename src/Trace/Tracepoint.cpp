@@ -0,0 +1,85 @@
+#include "Trace/Tracepoint.h"
+
+#ifdef TRACEPOINTS
+#include <Arduino_FreeRTOS.h>
+
+static_assert((TRACEPOINT_RING_SIZE & (TRACEPOINT_RING_SIZE - 1)) == 0,
+              "TRACEPOINT_RING_SIZE must be a power of two");
+
+struct TracepointRecord
+{
+    uint32_t timestampUs;
+    int32_t value;
+    TraceId id;
+};
+
+static TracepointRecord s_ring[TRACEPOINT_RING_SIZE];
+static uint32_t s_written = 0; // Records written since boot; the next one goes to s_written % size.
+
+void Tracepoint::record(TraceId id, int32_t value)
+{
+    // Interrupts may already be disabled in an ISR, so save and restore SREG.
+    uint8_t sreg = SREG;
+    cli();
+    TracepointRecord& slot = s_ring[s_written & (TRACEPOINT_RING_SIZE - 1)];
+    slot.timestampUs = micros();
+    slot.value = value;
+    slot.id = id;
+    s_written++;
+    SREG = sreg;
+}
+
+void Tracepoint::dump(Print& out)
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t end = s_written;
+    SREG = sreg;
+
+    uint32_t start = end > TRACEPOINT_RING_SIZE ? end - TRACEPOINT_RING_SIZE : 0;
+    for (uint32_t sequence = start; sequence < end; ++sequence)
+    {
+        TracepointRecord record;
+        bool valid;
+
+        sreg = SREG;
+        cli();
+        valid = s_written - sequence <= TRACEPOINT_RING_SIZE;
+        if (valid)
+        {
+            record = s_ring[sequence & (TRACEPOINT_RING_SIZE - 1)];
+        }
+        SREG = sreg;
+
+        if (!valid)
+        {
+            continue;
+        }
+
+        // Same layout as Trace::emit(): sync, id, length, timestamp, arguments.
+        uint8_t bytes[11] = {
+            TRACE_SYNC,
+            (uint8_t)record.id,
+            sizeof(record.value),
+            (uint8_t)record.timestampUs,
+            (uint8_t)(record.timestampUs >> 8),
+            (uint8_t)(record.timestampUs >> 16),
+            (uint8_t)(record.timestampUs >> 24),
+            (uint8_t)record.value,
+            (uint8_t)(record.value >> 8),
+            (uint8_t)(record.value >> 16),
+            (uint8_t)(record.value >> 24)
+        };
+        out.write(bytes, sizeof(bytes));
+    }
+}
+
+uint32_t Tracepoint::recordCount()
+{
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t written = s_written;
+    SREG = sreg;
+    return written;
+}
+#endif
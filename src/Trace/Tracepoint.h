@@ -0,0 +1,75 @@
+#ifndef AHA_DEVICES_TRACEPOINT_H
+#define AHA_DEVICES_TRACEPOINT_H
+
+#include "Debug.h"
+#include "Trace/TraceIds.h"
+
+// Records kept in RAM, must be a power of two. One record is 9 bytes.
+#ifndef TRACEPOINT_RING_SIZE
+#define TRACEPOINT_RING_SIZE 32
+#endif
+
+#ifdef TRACEPOINTS
+/**
+ * @brief Flight recorder for tracepoints: a RAM ring of the latest TRACEPOINT_RING_SIZE
+ * records, each an ID from TraceIds.h, a micros() timestamp and one 32-bit value.
+ * The oldest records are overwritten. dump() writes the ring in the binary Trace format,
+ * so tools/trace_decode.py can decode it.
+ */
+namespace Tracepoint
+{
+    /**
+     * @brief Appends a record stamped with the current micros(). Safe from tasks and ISRs,
+     * takes a few microseconds. The timestamp is taken with the ring locked, so timestamps
+     * increase in ring order.
+     */
+    void record(TraceId id, int32_t value);
+
+    /**
+     * @brief Writes the ring, oldest first, to an output such as Serial. Recording continues
+     * meanwhile; records overwritten during the dump are skipped.
+     */
+    void dump(Print& out);
+
+    /**
+     * @brief Returns the number of records written since boot.
+     */
+    uint32_t recordCount();
+
+    /**
+     * @class Scope
+     * @brief Records the duration of the enclosing block, see TRACE_SCOPE. The record is
+     * stamped at the end of the block, after the events recorded inside it.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(TraceId id) : _id(id), _startUs(micros()) {}
+        ~Scope() { record(_id, (int32_t)(micros() - _startUs)); }
+
+    private:
+        TraceId _id;
+        uint32_t _startUs;
+    };
+}
+#endif
+
+/**
+ * TRACE_EVENT(id, value) records a value, TRACE_SCOPE(id) the duration of the enclosing
+ * block in microseconds. Both compile to nothing unless the including .cpp defines
+ * TRACEPOINTS_ENABLED before including this header, which it does when its module flag
+ * (TRACEPOINTS_COVER, ...) is set in Debug.h:
+ *   #ifdef TRACEPOINTS_COVER
+ *   #define TRACEPOINTS_ENABLED
+ *   #endif
+ *   #include "Trace/Tracepoint.h"
+ */
+#ifdef TRACEPOINTS_ENABLED
+#define TRACE_EVENT(id, value) Tracepoint::record(TraceId::id, (int32_t)(value))
+#define TRACE_SCOPE(id) Tracepoint::Scope _tracepointScope(TraceId::id)
+#else
+#define TRACE_EVENT(id, value)
+#define TRACE_SCOPE(id)
+#endif
+
+#endif // AHA_DEVICES_TRACEPOINT_H
@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+# Builds the simavr image (bench/simavr/SimBench.cpp) and runs it on a simulated
+# ATmega2560 at 16 MHz. The firmware prints cycle counts over UART0, which simavr
+# echoes to stdout; the run ends when the image puts the CPU to sleep.
+# Exits non-zero unless the image reports "simavr: PASS" for its button event checks.
+#
+# Usage: tools/simavr_run.sh [timeout seconds, default 600]
+# Needs PlatformIO (pio) and simavr (e.g. apt install simavr) on PATH.
+set -euo pipefail
+
+cd "$(dirname "$0")/.."
+
+TIMEOUT="${1:-600}"
+ELF=".pio/build/simavr/firmware.elf"
+LOG=".pio/build/simavr/simavr.log"
+
+pio run -e simavr
+timeout "$TIMEOUT" simavr -m atmega2560 -f 16000000 "$ELF" | tee "$LOG"
+
+if ! grep -q "simavr: PASS" "$LOG"; then
+    echo "simavr: the image did not pass its checks" >&2
+    exit 1
+fi
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Decode the binary trace stream written by TPRINT (src/Trace/Trace.h).
+
+The record layout is [0xA5][id][length][micros u32][arguments], little-endian.
+IDs and format strings are read from src/Trace/TraceIds.h, so the same checkout
+that built the firmware must be used for decoding.
+
+Examples:
+    tools/trace_decode.py capture.bin
+    tools/trace_decode.py --port /dev/ttyACM0 --baud 115200    (needs pyserial)
+    cat /dev/ttyACM0 | tools/trace_decode.py -
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+HEADER_BYTES = 7
+
+DEFAULT_IDS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src", "Trace", "TraceIds.h")
+
+PLACEHOLDER = re.compile(r"\{(u8|u16|u32|i8|i16|i32|f|s)\}")
+FIXED = {
+    "u8": "<B", "u16": "<H", "u32": "<I",
+    "i8": "<b", "i16": "<h", "i32": "<i",
+    "f": "<f",
+}
+
+
+def load_ids(path):
+    """Returns a list of (name, format) in ID order from the TRACE_IDS X-macro."""
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    entries = re.findall(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', text)
+    if not entries:
+        sys.exit("no TRACE_IDS entries found in %s" % path)
+    return [(name, fmt.encode().decode("unicode_escape")) for name, fmt in entries]
+
+
+def format_args(fmt, payload):
+    """Substitutes the placeholders of fmt with values unpacked from payload."""
+    offset = 0
+    out = []
+    last = 0
+    for match in PLACEHOLDER.finditer(fmt):
+        out.append(fmt[last:match.start()])
+        last = match.end()
+        kind = match.group(1)
+        if kind == "s":
+            if offset >= len(payload):
+                out.append("<missing>")
+                continue
+            size = payload[offset]
+            value = payload[offset + 1:offset + 1 + size].decode("ascii", "replace")
+            offset += 1 + size
+            out.append(value)
+        else:
+            size = struct.calcsize(FIXED[kind])
+            if offset + size > len(payload):
+                out.append("<missing>")
+                offset = len(payload)
+                continue
+            (value,) = struct.unpack_from(FIXED[kind], payload, offset)
+            offset += size
+            out.append("%.2f" % value if kind == "f" else str(value))
+    out.append(fmt[last:])
+    if offset != len(payload):
+        out.append("  <%d extra bytes>" % (len(payload) - offset))
+    return "".join(out)
+
+
+class Decoder:
+    def __init__(self, ids):
+        self.ids = ids
+        self.buffer = bytearray()
+        self.last_us = None
+        self.wraps = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        """Consumes raw bytes and yields decoded text lines."""
+        self.buffer.extend(data)
+        while True:
+            start = self.buffer.find(bytes([SYNC]))
+            if start < 0:
+                self.skipped += len(self.buffer)
+                self.buffer.clear()
+                return
+            if start > 0:
+                self.skipped += start
+                del self.buffer[:start]
+            if len(self.buffer) < HEADER_BYTES:
+                return
+
+            record_id, length = self.buffer[1], self.buffer[2]
+            if record_id >= len(self.ids):
+                # Not a record header, resynchronise on the next sync byte.
+                self.skipped += 1
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < HEADER_BYTES + length:
+                return
+
+            (timestamp,) = struct.unpack_from("<I", self.buffer, 3)
+            payload = bytes(self.buffer[HEADER_BYTES:HEADER_BYTES + length])
+            del self.buffer[:HEADER_BYTES + length]
+            yield self.format(record_id, timestamp, payload)
+
+    def format(self, record_id, timestamp, payload):
+        # micros() wraps every ~71.6 minutes. A small step back is not a wrap but a record
+        # stamped before an earlier one was written (e.g. a Tracepoint scope).
+        if self.last_us is not None and timestamp < self.last_us and self.last_us - timestamp > 1 << 31:
+            self.wraps += 1
+        self.last_us = timestamp
+        total_us = (self.wraps << 32) + timestamp
+
+        name, fmt = self.ids[record_id]
+        return "%12.3f ms  %-20s %s" % (total_us / 1000.0, name, format_args(fmt, payload))
+
+
+def open_input(args):
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("--port needs pyserial (pip install pyserial)")
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        return lambda: port.read(256)
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    return lambda: stream.read(256)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", default="-", help="captured file, or - for stdin")
+    parser.add_argument("--port", help="serial port to read live")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--ids", default=DEFAULT_IDS, help="path to TraceIds.h")
+    args = parser.parse_args()
+
+    decoder = Decoder(load_ids(args.ids))
+    read = open_input(args)
+    try:
+        while True:
+            data = read()
+            if not data:
+                if args.port:
+                    continue
+                break
+            for line in decoder.feed(data):
+                print(line, flush=True)
+    except KeyboardInterrupt:
+        pass
+
+    if decoder.skipped:
+        print("(%d bytes outside of records skipped)" % decoder.skipped, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()